@@ -30,7 +30,7 @@ class AccInfoFlags
     Node                *node;
     IntersectionFlags   intersectionFlags;
     IntersectionFlags   intersectionFlagsMF;
-    unsigned char       accSubID;
+    int                 accSubID;
 
 public:
 
@@ -210,19 +210,26 @@ public:
     int GetAccSubID() const { return accSubID; }
     void SetAccSubID(int id) { accSubID = id; }
 
-private:
-
-    void UpdateAccIntersectionFlags(const IntersectionFlags &flags, const IntersectionFlags &flagsMF)
+    // static so it can be benchmarked without building a graph
+    static void UpdateAccIntersectionFlags(IntersectionFlags &intersectionFlags, IntersectionFlags &intersectionFlagsMF, const IntersectionFlags &flags, const IntersectionFlags &flagsMF)
     {
+        typedef IntersectionFlagsHelpers<IntersectionFlags> Helpers;
         // if flags are already set then we're done
-        if ((intersectionFlags & flags) == flags)
+        if (Helpers::AndNot(flags, intersectionFlags) == 0)
         {
             return;
         }
         intersectionFlags |= flags;
         intersectionFlagsMF |= flagsMF;
-        IntersectionFlags flagsSubfaces = flags & (~flagsMF);
-        intersectionFlagsMF &= (~flagsSubfaces);
+        IntersectionFlags flagsSubfaces = Helpers::AndNot(flags, flagsMF);
+        intersectionFlagsMF = Helpers::AndNot(intersectionFlagsMF, flagsSubfaces);
+    }
+
+private:
+
+    void UpdateAccIntersectionFlags(const IntersectionFlags &flags, const IntersectionFlags &flagsMF)
+    {
+        UpdateAccIntersectionFlags(intersectionFlags, intersectionFlagsMF, flags, flagsMF);
     }
 
 };
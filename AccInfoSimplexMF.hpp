@@ -25,7 +25,7 @@ class AccInfoSimplexMF
     Node                *node;
     // list of NORMALIZED maximal faces
     SimplexList         intersectionMF;
-    unsigned char       accSubID;
+    int                 accSubID;
 
 public:
 
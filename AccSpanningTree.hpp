@@ -16,6 +16,11 @@
 #include <vector>
 #include <set>
 #include <map>
+#include <algorithm> // swap, fill
+
+#ifdef USE_OMP
+#include <omp.h>
+#endif
 
 #ifdef ACCSUB_TRACE
 #include "Utils.hpp"
@@ -51,6 +56,7 @@ public:
         std::vector<Vertex>     boundaryVertsToConnect;
         std::vector<Path>       boundaryVertsConnectingPaths;
         bool                    isConnectedToAccSub;
+        std::vector<std::pair<Vertex, Vertex> > *addedEdges;
 
         Node(PartitionGraphNode *parent, int id, ConnectedComponent connectedComponent, std::set<Vertex> &borderVerts, int accSubSize)
         {
@@ -60,6 +66,7 @@ public:
             this->borderVerts = borderVerts;
             this->accSubSize = accSubSize;
             this->isConnectedToAccSub = false;
+            this->addedEdges = 0;
         }
 
         void AddEdge(Edge *edge)
@@ -133,20 +140,20 @@ public:
                 }
                 else if ((*i)->GetAccInfo().IsVertexInAccIntersection(vertex))
                 {
-                    prevNode->GetAccInfo().UpdateAccIntersectionWithEdge(lastVertex, vertex);
+                    AddEdgeToAccSub(prevNode, lastVertex, vertex);
                     prevNode = 0;
                     break;
                 }
                 else
                 {
                     vertsOnPath.insert(vertex);
-                    prevNode->GetAccInfo().UpdateAccIntersectionWithEdge(lastVertex, vertex);
+                    AddEdgeToAccSub(prevNode, lastVertex, vertex);
                     prevNode = (*i);
                     lastVertex = vertex;
                     vertex = prevNode->GetAccInfo().FindAccVertexNotIn(vertsOnPath);
                     if (vertex != Vertex(-1))
                     {
-                        prevNode->GetAccInfo().UpdateAccIntersectionWithEdge(lastVertex, vertex);
+                        AddEdgeToAccSub(prevNode, lastVertex, vertex);
                         prevNode = 0;
                         break;
                     }
@@ -157,7 +164,7 @@ public:
             {
                 Vertex vertex = prevNode->GetAccInfo().FindAccVertexNotEqual(lastVertex);
                 assert(vertex != Vertex(-1));
-                prevNode->GetAccInfo().UpdateAccIntersectionWithEdge(lastVertex, vertex);
+                AddEdgeToAccSub(prevNode, lastVertex, vertex);
 
             }
         }
@@ -173,7 +180,7 @@ public:
         // another part of acyclic subset we stop.
         void UpdatePathFromAccSubToBorder(Vertex borderVertex, Path &path)
         {
-            path.reverse();
+            std::reverse(path.begin(), path.end());
             typename Path::iterator i = path.begin();
             IncidenceGraphNode *prevNode = *i;
             i++;
@@ -189,13 +196,13 @@ public:
                 }
                 else if ((*i)->GetAccInfo().IsVertexInAccIntersection(vertex))
                 {
-                    prevNode->GetAccInfo().UpdateAccIntersectionWithEdge(lastVertex, vertex);
+                    AddEdgeToAccSub(prevNode, lastVertex, vertex);
                     prevNode = 0;
                     break;
                 }
                 else
                 {
-                    prevNode->GetAccInfo().UpdateAccIntersectionWithEdge(lastVertex, vertex);
+                    AddEdgeToAccSub(prevNode, lastVertex, vertex);
                     prevNode = (*i);
                     lastVertex = vertex;
                 }
@@ -210,11 +217,31 @@ public:
                 // check that we don't add degenerated edge
                 if (lastVertex != borderVertex)
                 {
-                    prevNode->GetAccInfo().UpdateAccIntersectionWithEdge(lastVertex, borderVertex);
+                    AddEdgeToAccSub(prevNode, lastVertex, borderVertex);
                 }
             }
         }
 
+        // if addedEdges is set, edges (and vertices as degenerated edges)
+        // added to acyclic subset are recorded there
+        void AddEdgeToAccSub(IncidenceGraphNode *node, Vertex v1, Vertex v2)
+        {
+            node->GetAccInfo().UpdateAccIntersectionWithEdge(v1, v2);
+            if (addedEdges != 0)
+            {
+                addedEdges->push_back(std::pair<Vertex, Vertex>(v1, v2));
+            }
+        }
+
+        void AddVertexToAccSub(IncidenceGraphNode *node, Vertex v)
+        {
+            node->GetAccInfo().UpdateAccIntersectionWithVertex(v);
+            if (addedEdges != 0)
+            {
+                addedEdges->push_back(std::pair<Vertex, Vertex>(v, v));
+            }
+        }
+
         // finding paths connect boundary vertices
         void FindBoundaryVertsConnectingPaths()
         {
@@ -253,7 +280,7 @@ public:
             typename std::vector<Vertex>::iterator vertex = boundaryVertsToConnect.begin();
             Vertex firstVertex = *vertex;
             IncidenceGraphNode *firstNode = FindNode(connectedComponent, FindNodeWithVertex<IncidenceGraph>(firstVertex));
-            firstNode->GetAccInfo().UpdateAccIntersectionWithVertex(firstVertex);
+            AddVertexToAccSub(firstNode, firstVertex);
             vertex++;
             for (typename std::vector<Path>::iterator path = boundaryVertsConnectingPaths.begin(); path != boundaryVertsConnectingPaths.end(); path++, vertex++)
             {
@@ -280,20 +307,20 @@ public:
                     }
                     else if ((*i)->GetAccInfo().IsVertexInAccIntersection(vertex))
                     {
-                        prevNode->GetAccInfo().UpdateAccIntersectionWithEdge(lastVertex, vertex);
+                        AddEdgeToAccSub(prevNode, lastVertex, vertex);
                         prevNode = 0;
                         break;
                     }
                     else
                     {
                         vertsOnPath.insert(vertex);
-                        prevNode->GetAccInfo().UpdateAccIntersectionWithEdge(lastVertex, vertex);
+                        AddEdgeToAccSub(prevNode, lastVertex, vertex);
                         prevNode = (*i);
                         lastVertex = vertex;
                         vertex = prevNode->GetAccInfo().FindAccVertexNotIn(vertsOnPath);
                         if (vertex != Vertex(-1))
                         {
-                            prevNode->GetAccInfo().UpdateAccIntersectionWithEdge(lastVertex, vertex);
+                            AddEdgeToAccSub(prevNode, lastVertex, vertex);
                             prevNode = 0;
                             break;
                         }
@@ -308,7 +335,7 @@ public:
                     // check that we don't add degenerated edge
                     if (lastVertex != firstVertex)
                     {
-                        prevNode->GetAccInfo().UpdateAccIntersectionWithEdge(lastVertex, firstVertex);
+                        AddEdgeToAccSub(prevNode, lastVertex, firstVertex);
                     }
                 }
             }
@@ -365,6 +392,63 @@ public:
     Edges edges;
 
     AccSpanningTreeT(PartitionGraph *pg)
+    {
+        CreateSpanningTree(pg->nodes);
+        FindPaths(pg->isolatedNodes);
+    }
+
+    ~AccSpanningTreeT()
+    {
+        for (typename Nodes::iterator i = nodes.begin(); i != nodes.end(); i++)
+        {
+            delete (*i);
+        }
+        for (typename Edges::iterator i = edges.begin(); i != edges.end(); i++)
+        {
+            delete (*i);
+        }
+    }
+
+    void JoinAccSubsets()
+    {
+        // paths need to be found in previous steps
+        for (typename Edges::iterator i = edges.begin(); i != edges.end(); i++)
+        {
+            if ((*i)->isInSpanningTree) (*i)->UpdateAccConnections();
+        }
+#ifdef ACCSUB_TRACE
+        Timer::Update("adding paths to acyclic subset");
+#endif
+    }
+
+    // number of edges from which spanning tree edges are selected
+    // in parallel (only with USE_OMP, 0 - always sequential)
+    static int parallelMinEdges;
+
+    // union-find root with path compression, parents are indexed
+    // by subtree ids
+    static int FindRoot(std::vector<int> &parents, int id)
+    {
+        int root = id;
+        while (parents[root] != root)
+        {
+            root = parents[root];
+        }
+        while (parents[id] != root)
+        {
+            int next = parents[id];
+            parents[id] = root;
+            id = next;
+        }
+        return root;
+    }
+
+private:
+
+    // sizes of acyclic subsets in trees indexed by subtree ids
+    std::vector<int> spanningTreeAccSubSize;
+
+    void CreateSpanningTree(typename PartitionGraph::Nodes &dataNodes)
     {
         // we build a graph in which nodes are disjoint parts of acyclic
         // subset and edges are paths connecting them
@@ -372,7 +456,7 @@ public:
         // paths into one big acyclic subset
         typename std::map<PartitionGraphNode *, std::vector<Node *> > dataNodeChildren;
         int currentID = 1;
-        for (typename PartitionGraph::Nodes::iterator i = pg->nodes.begin(); i != pg->nodes.end(); i++)
+        for (typename PartitionGraph::Nodes::iterator i = dataNodes.begin(); i != dataNodes.end(); i++)
         {
             IncidenceGraph *ig = (*i)->ig;
             typename std::vector<std::set<Vertex> >::iterator ccb = ig->connectedComponentsBorders.begin();
@@ -422,39 +506,148 @@ public:
         Timer::Update("creating acyclic tree edges");
 #endif
 
-        // we create hash in which keys are IDs of every part
-        // of acyclic subset and values are sizes of this sets/
-        std::map<int, int> spanningTreeAccSubSize;
+        // subtrees are kept in union-find structure indexed by initial ids
+        // of nodes (path compression, union by size). label of a subtree is
+        // the id of nodeA's subtree from the edge that joined it, so ids
+        // are the same as if the nodes were relabelled edge by edge
+        int count = nodes.size();
+        std::vector<int> parents(count + 1);
+        std::vector<int> sizes(count + 1, 1);
+        std::vector<int> labels(count + 1);
+        spanningTreeAccSubSize.assign(count + 1, 0);
         for (typename Nodes::iterator node = nodes.begin(); node != nodes.end(); node++)
         {
-            spanningTreeAccSubSize[(*node)->subtreeID] = (*node)->accSubSize;
+            int id = (*node)->subtreeID;
+            parents[id] = id;
+            labels[id] = id;
+            spanningTreeAccSubSize[id] = (*node)->accSubSize;
+        }
+
+        bool edgesSelected = false;
+#ifdef USE_OMP
+        if (parallelMinEdges > 0 && (int)edges.size() >= parallelMinEdges)
+        {
+            SelectSpanningTreeEdgesParallel(count);
+            edgesSelected = true;
         }
+#endif
 
         for (typename Edges::iterator edge = edges.begin(); edge != edges.end(); edge++)
         {
-            if ((*edge)->nodeA->subtreeID == (*edge)->nodeB->subtreeID)
+            if (edgesSelected && !(*edge)->isInSpanningTree)
+            {
+                continue;
+            }
+            int rootA = FindRoot(parents, (*edge)->nodeA->subtreeID);
+            int rootB = FindRoot(parents, (*edge)->nodeB->subtreeID);
+            if (rootA == rootB)
             {
                 continue;
             }
             (*edge)->isInSpanningTree = true;
-            int newID = (*edge)->nodeA->subtreeID;
-            int oldID = (*edge)->nodeB->subtreeID;
+            int label = labels[rootA];
             // while connecting two trees into one we also sum the sizes
             // of acyclic subsets in each tree
-            spanningTreeAccSubSize[newID] = spanningTreeAccSubSize[newID] + spanningTreeAccSubSize[oldID];
-            for (typename Nodes::iterator node = nodes.begin(); node != nodes.end(); node++)
+            spanningTreeAccSubSize[label] += spanningTreeAccSubSize[labels[rootB]];
+            if (sizes[rootA] < sizes[rootB])
             {
-                if ((*node)->subtreeID == oldID)
-                {
-                    (*node)->subtreeID = newID;
-                }
+                std::swap(rootA, rootB);
             }
+            parents[rootB] = rootA;
+            sizes[rootA] += sizes[rootB];
+            labels[rootA] = label;
+        }
+
+        for (typename Nodes::iterator node = nodes.begin(); node != nodes.end(); node++)
+        {
+            (*node)->subtreeID = labels[FindRoot(parents, (*node)->subtreeID)];
         }
 
 #ifdef ACCSUB_TRACE
         Timer::Update("creating spanning tree");
 #endif
+    }
 
+#ifdef USE_OMP
+    // Boruvka rounds: every subtree picks its cheapest outgoing edge, where
+    // cost of an edge is its index. with distinct costs minimal spanning
+    // forest is unique, so selected edges are the same as those chosen by
+    // sequential pass in CreateSpanningTree. edges are scanned in parallel,
+    // every thread keeps its own cheapest edges which are then reduced
+    void SelectSpanningTreeEdgesParallel(int count)
+    {
+        int edgesCount = edges.size();
+        std::vector<int> parents(count + 1);
+        std::vector<int> components(count + 1);
+        for (int i = 0; i <= count; i++)
+        {
+            parents[i] = i;
+            components[i] = i;
+        }
+        std::vector<int> cheapest(count + 1);
+        std::vector<std::vector<int> > threadsCheapest(omp_get_max_threads(), std::vector<int>(count + 1));
+        bool merged = true;
+        while (merged)
+        {
+            merged = false;
+            #pragma omp parallel
+            {
+                int threadsCount = omp_get_num_threads();
+                std::vector<int> &local = threadsCheapest[omp_get_thread_num()];
+                std::fill(local.begin(), local.end(), edgesCount);
+                // static schedule, so every thread visits its edges in
+                // increasing order and the first one found is the cheapest
+                #pragma omp for schedule(static)
+                for (int i = 0; i < edgesCount; i++)
+                {
+                    int a = components[edges[i]->nodeA->subtreeID];
+                    int b = components[edges[i]->nodeB->subtreeID];
+                    if (a == b)
+                    {
+                        continue;
+                    }
+                    if (local[a] == edgesCount) local[a] = i;
+                    if (local[b] == edgesCount) local[b] = i;
+                }
+                #pragma omp for schedule(static)
+                for (int c = 0; c <= count; c++)
+                {
+                    int min = edgesCount;
+                    for (int t = 0; t < threadsCount; t++)
+                    {
+                        if (threadsCheapest[t][c] < min) min = threadsCheapest[t][c];
+                    }
+                    cheapest[c] = min;
+                }
+            }
+            for (int c = 0; c <= count; c++)
+            {
+                if (cheapest[c] == edgesCount)
+                {
+                    continue;
+                }
+                Edge *edge = edges[cheapest[c]];
+                int rootA = FindRoot(parents, edge->nodeA->subtreeID);
+                int rootB = FindRoot(parents, edge->nodeB->subtreeID);
+                // both subtrees may pick the same edge
+                if (rootA == rootB)
+                {
+                    continue;
+                }
+                edge->isInSpanningTree = true;
+                parents[rootB] = rootA;
+                merged = true;
+            }
+            for (int i = 0; i <= count; i++)
+            {
+                components[i] = FindRoot(parents, i);
+            }
+        }
+    }
+#endif
+
+    void FindPaths(typename PartitionGraph::Nodes &isolatedNodes)
+    {
         // if there is a tree with acyclic subset size equal to zero this
         // mean that there is a connected component in simplicial complex
         // in which we didn't found any acyclic subset (probably beacuse
@@ -496,7 +689,7 @@ public:
         // and incidence graph
         for (typename std::map<int, SimplexPtrList>::iterator i = simplexPtrLists.begin(); i != simplexPtrLists.end(); i++)
         {
-            pg->isolatedNodes.push_back(new PartitionGraphNode(i->second));
+            isolatedNodes.push_back(new PartitionGraphNode(i->second));
         }
 
 #ifdef ACCSUB_TRACE
@@ -516,32 +709,11 @@ public:
 
 #ifdef ACCSUB_TRACE
         Timer::Update("searching paths from acyclic subsets to border");
-#endif
-    }
-
-    ~AccSpanningTreeT()
-    {
-        for (typename Nodes::iterator i = nodes.begin(); i != nodes.end(); i++)
-        {
-            delete (*i);
-        }
-        for (typename Edges::iterator i = edges.begin(); i != edges.end(); i++)
-        {
-            delete (*i);
-        }
-    }
-
-    void JoinAccSubsets()
-    {
-        // paths need to be found in previous steps
-        for (typename Edges::iterator i = edges.begin(); i != edges.end(); i++)
-        {
-            if ((*i)->isInSpanningTree) (*i)->UpdateAccConnections();
-        }
-#ifdef ACCSUB_TRACE
-        Timer::Update("adding paths to acyclic subset");
 #endif
     }
 };
 
+template <typename PartitionGraph>
+int AccSpanningTreeT<PartitionGraph>::parallelMinEdges = 1 << 12;
+
 #endif /* ACCSPANNINGTREE_HPP */
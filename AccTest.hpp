@@ -12,15 +12,19 @@
 #ifndef ACCTEST_HPP
 #define ACCTEST_HPP
 
+#include <deque>
 #include <map>
 #include <queue>
 #include <set>
 #include <string>
+#include <vector>
 
 #include <cassert>
 
 #include "ConfigurationsFlags.hpp"
+#include "IntersectionFlagsHelpers.hpp"
 #include "RedHomHelpers.hpp"
+#include "Utils.hpp"
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -30,6 +34,11 @@ class AccTestStats
     int fullTests;
     int acyclic;
     int notAcyclic;
+    int undecided;
+    // decisions made by each tier of the cascade test
+    std::vector<int> tiersIDs;
+    std::vector<int> tiersAcyclic;
+    std::vector<int> tiersNotAcyclic;
 
 public:
 
@@ -39,6 +48,51 @@ public:
         fullTests = 0;
         acyclic = 0;
         notAcyclic = 0;
+        undecided = 0;
+    }
+
+    void AddTier(int id)
+    {
+        tiersIDs.push_back(id);
+        tiersAcyclic.push_back(0);
+        tiersNotAcyclic.push_back(0);
+    }
+
+    void Merge(const AccTestStats &stats)
+    {
+        allTests += stats.allTests;
+        fullTests += stats.fullTests;
+        acyclic += stats.acyclic;
+        notAcyclic += stats.notAcyclic;
+        undecided += stats.undecided;
+        if (tiersIDs.size() == 0)
+        {
+            tiersIDs = stats.tiersIDs;
+            tiersAcyclic.assign(tiersIDs.size(), 0);
+            tiersNotAcyclic.assign(tiersIDs.size(), 0);
+        }
+        assert(tiersIDs == stats.tiersIDs);
+        for (int i = 0; i < (int)tiersIDs.size(); i++)
+        {
+            tiersAcyclic[i] += stats.tiersAcyclic[i];
+            tiersNotAcyclic[i] += stats.tiersNotAcyclic[i];
+        }
+    }
+
+    void TierDecision(int tier, int result)
+    {
+        if (result > 0)
+        {
+            tiersAcyclic[tier]++;
+        }
+        else if (result < 0)
+        {
+            tiersNotAcyclic[tier]++;
+        }
+        else
+        {
+            undecided++;
+        }
     }
 
     void TestPerformed()
@@ -83,6 +137,14 @@ public:
         }
         std::cout<<"acyclic: "<<acyclic<<std::endl;
         std::cout<<"not acyclic: "<<notAcyclic<<std::endl;
+        for (int i = 0; i < (int)tiersIDs.size(); i++)
+        {
+            std::cout<<"tier "<<i<<" (test "<<tiersIDs[i]<<") acyclic: "<<tiersAcyclic[i]<<" not acyclic: "<<tiersNotAcyclic[i]<<std::endl;
+        }
+        if (undecided > 0)
+        {
+            std::cout<<"undecided: "<<undecided<<std::endl;
+        }
     }
 };
 
@@ -97,44 +159,28 @@ class AccTestT
 
 protected:
 
-    int *flagsDimensions;
     int dim;
-
-    int NewtonCoefficient(int n, int k)
-    {
-        if (k > n / 2)
-        {
-            k = n - k;
-        }
-        int numerator = n;
-        int denominator = 1;
-        for (int i = 2; i <= k; i++)
-        {
-            numerator *= (n - i + 1);
-            denominator *= i;
-        }
-        return numerator / denominator;
-    }
-
-    void CreateFlagsDimensions()
-    {
-        flagsDimensions = new int[dim + 1];
-        int index = 0;
-        for (int i = 0; i < dim; i++)
-        {
-            index += this->NewtonCoefficient(dim + 1, i + 1);
-            flagsDimensions[i] = index;
-        }
-    }
+    ConfigurationsDimensionsMasks<IntersectionFlags> dimensionsMasks;
 
 public:
 
-    AccTestT(int d) : dim(d), flagsDimensions(0) { }
-    virtual ~AccTestT() { delete [] flagsDimensions; };
+    AccTestT(int d) : dim(d), dimensionsMasks(d) { }
+    virtual ~AccTestT() { };
     virtual bool IsAcyclic(const Simplex &simplex, SimplexList &intersectionMF) = 0;
     virtual bool IsAcyclic(const Simplex &simplex, const IntersectionFlags &intersectionFlags, const IntersectionFlags &intersectionFlagsMF) = 0;
     virtual int GetID() = 0;
 
+    // returns 1 if intersection is acyclic, -1 if it is not and 0 if
+    // the test can not decide. partial tests override it to report
+    // configurations they know are not acyclic, so they can be used
+    // as tiers of AccTestCascade
+    virtual int Decide(const Simplex &simplex, const IntersectionFlags &intersectionFlags, const IntersectionFlags &intersectionFlagsMF)
+    {
+        return IsAcyclic(simplex, intersectionFlags, intersectionFlagsMF) ? 1 : 0;
+    }
+
+    virtual AccTestStats *GetStats() { return 0; }
+
     int TrivialTest(const Simplex &simplex, SimplexList &intersectionMF)
     {
         if (intersectionMF.size() == 0)
@@ -161,28 +207,21 @@ public:
         return 0;
     }
 
+    // acyclic intersection has Euler characteristic equal to 1, so this
+    // is a cheap necessary condition that can be checked before full test
+    int EulerTest(const IntersectionFlags &intersectionFlags)
+    {
+        return (EulerCharacteristic(intersectionFlags) != 1) ? -1 : 0;
+    }
+
     int EulerCharacteristic(const IntersectionFlags &intersectionFlags)
     {
-        int currentDim = 0;
-        int index = 0;
-        int eulerCharacteristics = 0;
-        int delta = 1;
-        int flags = 1;
-        while (currentDim < dim)
-        {
-            if (intersectionFlags & flags)
-            {
-                eulerCharacteristics += delta;
-            }
-            flags = flags << 1;
-            index++;
-            while (index >= this->flagsDimensions[currentDim] && currentDim < dim)
-            {
-                currentDim++;
-                delta = -delta;
-            }
-        }
-        return eulerCharacteristics;
+        return dimensionsMasks.GetEulerCharacteristic(intersectionFlags);
+    }
+
+    const ConfigurationsDimensionsMasks<IntersectionFlags> &GetDimensionsMasks() const
+    {
+        return dimensionsMasks;
     }
 
     static AccTestT *Create(int accTestNumber, int dim);
@@ -191,6 +230,7 @@ public:
 
 #define TRIVIAL_TEST_I(s, i) int tt = this->TrivialTest(s, i); if (tt < 0) return false; else if (tt > 0) return true;
 #define TRIVIAL_TEST_F(s, i, im) int tt = this->TrivialTest(s, i, im); if (tt < 0) return false; else if (tt > 0) return true;
+#define EULER_TEST_F(i) if (this->EulerTest(i) < 0) return false;
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -282,6 +322,11 @@ public:
         return GetValue((int)intersectionFlags);
     }
 
+    int Decide(const Simplex &simplex, const IntersectionFlags &intersectionFlags, const IntersectionFlags &intersectionFlagsMF)
+    {
+        return IsAcyclic(simplex, intersectionFlags, intersectionFlagsMF) ? 1 : -1;
+    }
+
     int GetID() { return 0; }
 
 private:
@@ -313,13 +358,14 @@ class AccTestCodim1 : public AccTestT<Traits>
     typedef typename Traits::IntersectionFlags IntersectionFlags;
 
     int maxSimplexSize;
-    std::map<int, IntersectionFlags> codim1flags;
+    std::vector<IntersectionFlags> codim1flags;
 
 public:
 
     AccTestCodim1(int dim) : AccTestT<Traits>(dim)
     {
         maxSimplexSize = dim + 1;
+        codim1flags.resize(maxSimplexSize + 1, 0);
 
         ConfigurationsFlags<Simplex, IntersectionFlags> configurationsFlags(dim, false, false);
 
@@ -331,7 +377,7 @@ public:
             IntersectionFlags flags = 0;
             for (typename SimplexList::iterator i = faces.begin(); i != faces.end(); i++)
             {
-                if ((*i).size() == d - 1)
+                if ((int)(*i).size() == d - 1)
                 {
                     flags |= configurationsFlags[*i];
                 }
@@ -347,7 +393,7 @@ public:
         int d = simplex.size() - 1;
         for (typename SimplexList::iterator i = intersectionMF.begin(); i != intersectionMF.end(); i++)
         {
-            if (i->size() != d)
+            if ((int)i->size() != d)
             {
                   return false;
             }
@@ -357,15 +403,21 @@ public:
 
     bool IsAcyclic(const Simplex &simplex, const IntersectionFlags &intersectionFlags, const IntersectionFlags &intersectionFlagsMF)
     {
-        TRIVIAL_TEST_F(simplex, intersectionFlags, intersectionFlagsMF);
+        return Decide(simplex, intersectionFlags, intersectionFlagsMF) > 0;
+    }
+
+    int Decide(const Simplex &simplex, const IntersectionFlags &intersectionFlags, const IntersectionFlags &intersectionFlagsMF)
+    {
+        int tt = this->TrivialTest(simplex, intersectionFlags, intersectionFlagsMF);
+        if (tt != 0) return tt;
         int d = simplex.size();
-        if (d > maxSimplexSize) return false;
-        IntersectionFlags flags = codim1flags[d];
-        // intersection contains all faces with CoDim == 1
-        if ((intersectionFlagsMF & flags) == flags) return false;
+        if (d > maxSimplexSize) return 0;
+        const IntersectionFlags &flags = codim1flags[d];
+        // intersection contains all faces with CoDim == 1 (whole boundary)
+        if ((intersectionFlagsMF & flags) == flags) return -1;
         // intersection contains faces with CoDim != 1
-        if ((intersectionFlagsMF & (~flags)) != 0) return false;
-        return true;
+        if ((intersectionFlagsMF & (~flags)) != 0) return 0;
+        return 1;
     }
 
     int GetID() { return 1; }
@@ -385,7 +437,8 @@ class AccTestStar : public AccTestT<Traits>
     int lastMaximalFacePower;
     Vertex firstVertex;
     Vertex lastVertex;
-    std::map<IntersectionFlags, IntersectionFlags> confToSubconf;
+    // subconfiguration flags of face with flag 1 << i
+    std::vector<IntersectionFlags> subconfFlags;
 
 public:
 
@@ -399,13 +452,14 @@ public:
         ConfigurationsFlags<Simplex, IntersectionFlags> configurationsFlags(dim, false, false);
         ConfigurationsFlags<Simplex, IntersectionFlags> subconfigurationsFlags(dim, true, false);
 
-        IntersectionFlags flag = 1 << firstMaximalFacePower;
+        subconfFlags.resize(lastMaximalFacePower, 0);
+        IntersectionFlags flag = IntersectionFlagsHelpers<IntersectionFlags>::Bit(firstMaximalFacePower);
         for (int i = firstMaximalFacePower; i < lastMaximalFacePower; i++)
         {
             Simplex s;
             if (configurationsFlags.GetSimplex(flag, s))
             {
-                confToSubconf[flag] = subconfigurationsFlags[s];
+                subconfFlags[i] = subconfigurationsFlags[s];
             }
             else
             {
@@ -464,30 +518,28 @@ public:
 
     bool IsAcyclic(const Simplex &simplex, const IntersectionFlags &intersectionFlags, const IntersectionFlags &intersectionFlagsMF)
     {
-        TRIVIAL_TEST_F(simplex, intersectionFlags, intersectionFlagsMF);
+        return Decide(simplex, intersectionFlags, intersectionFlagsMF) > 0;
+    }
+
+    int Decide(const Simplex &simplex, const IntersectionFlags &intersectionFlags, const IntersectionFlags &intersectionFlagsMF)
+    {
+        int tt = this->TrivialTest(simplex, intersectionFlags, intersectionFlagsMF);
+        if (tt != 0) return tt;
         // if we have more than one vertex that is maximal face
         // the intersection is not acyclic
-        IntersectionFlags flag = 1;
-        int vertsCount = 0;
-        for (int i = 0; i < firstMaximalFacePower; i++)
+        int vertsCount = this->dimensionsMasks.GetFacesCount(intersectionFlagsMF, 0);
+        if (vertsCount > 1)
         {
-            if ((intersectionFlagsMF & flag) == flag)
-            {
-                vertsCount++;
-                if (vertsCount > 1)
-                {
-                    return false;
-                }
-            }
-            flag = flag << 1;
+            return -1;
         }
+        IntersectionFlags flag = IntersectionFlagsHelpers<IntersectionFlags>::Bit(firstMaximalFacePower);
         // computing flags for faces of dimension greater than 0
         std::vector<IntersectionFlags> maximalFacesFlags;
         for (int i = firstMaximalFacePower; i < lastMaximalFacePower; i++)
         {
             if ((intersectionFlagsMF & flag) == flag)
             {
-                maximalFacesFlags.push_back(confToSubconf[flag]);
+                maximalFacesFlags.push_back(subconfFlags[i]);
             }
             flag = flag << 1;
         }
@@ -495,14 +547,14 @@ public:
         // then the intersection is acyclic
         if (maximalFacesFlags.size() == 0)
         {
-            return true;
+            return 1;
         }
         // if there are faces of dimension greater than 0 and there is
         // at least one vertex being maximal face then the intersection
         // is not acyclic
         else if (vertsCount > 0)
         {
-            return false;
+            return -1;
         }
         // finally we try to find a vertex that is contained in all
         // maximal faces. if we find such then we have a start topology
@@ -518,13 +570,13 @@ public:
                     count++;
                 }
             }
-            if (count == maximalFacesFlags.size())
+            if (count == (int)maximalFacesFlags.size())
             {
-                return true;
+                return 1;
             }
             flag = flag << 1;
         }
-        return false;
+        return 0;
     }
 
     int GetID() { return 2; }
@@ -563,25 +615,38 @@ class AccTestRecursive : public AccTestT<Traits>
             isAddedToQueue = false;
         }
 
-        void GetNeighboursNotInAccSub(const std::vector<MaximalFacePtr> &faces, std::vector<MaximalFacePtr> &neighbours)
+        void GetNeighboursNotInAccSub(std::vector<MaximalFace> &faces, std::vector<MaximalFacePtr> &neighbours)
         {
             neighbours.clear();
-            for (typename std::vector<MaximalFacePtr>::const_iterator f = faces.begin(); f != faces.end(); f++)
+            for (typename std::vector<MaximalFace>::iterator f = faces.begin(); f != faces.end(); f++)
             {
-                if ((*f) == this || (*f)->isInAccSub)
+                if (&(*f) == this || f->isInAccSub)
                 {
                     continue;
                 }
-                if ((subconfFlags & (*f)->subconfFlags) != 0)
+                if ((subconfFlags & f->subconfFlags) != 0)
                 {
-                    neighbours.push_back((*f));
+                    neighbours.push_back(&(*f));
                 }
             }
         }
     };
 
+    // buffers reused between calls. test is called recursively for
+    // intersections of maximal faces, so there is one per recursion level
+    struct Scratch
+    {
+        std::vector<MaximalFace> maximalFaces;
+        std::vector<MaximalFacePtr> queue;
+        std::vector<MaximalFacePtr> neighbours;
+        std::vector<MaximalFacePtr> updatedNeighbours;
+    };
+
     int lastMaximalFacePower;
-    std::map<IntersectionFlags, IntersectionFlags> confToSubconf;
+    // subconfiguration flags of face with flag 1 << i
+    std::vector<IntersectionFlags> subconfFlags;
+    // deque doesn't move existing elements when new level is added
+    ThreadsData<std::deque<Scratch> > threadsScratch;
 
 public:
 
@@ -592,13 +657,15 @@ public:
         ConfigurationsFlags<Simplex, IntersectionFlags> configurationsFlags(dim, false, false);
         ConfigurationsFlags<Simplex, IntersectionFlags> subconfigurationsFlags(dim, true, false);
 
+        // last entry (maximal simplex) is left empty
+        subconfFlags.resize(lastMaximalFacePower + 1, 0);
         IntersectionFlags flag = 1;
         for (int i = 0; i < lastMaximalFacePower; i++)
         {
             Simplex s;
             if (configurationsFlags.GetSimplex(flag, s))
             {
-                confToSubconf[flag] = subconfigurationsFlags[s];
+                subconfFlags[i] = subconfigurationsFlags[s];
             }
             else
             {
@@ -646,67 +713,81 @@ public:
     }
 
     bool IsAcyclic(const Simplex &simplex, const IntersectionFlags &intersectionFlags, const IntersectionFlags &intersectionFlagsMF)
+    {
+        return IsAcyclic(simplex, intersectionFlags, intersectionFlagsMF, 0);
+    }
+
+    int GetID() { return 3; }
+
+private:
+
+    bool IsAcyclic(const Simplex &simplex, const IntersectionFlags &intersectionFlags, const IntersectionFlags &intersectionFlagsMF, int level)
     {
         TRIVIAL_TEST_F(simplex, intersectionFlags, intersectionFlagsMF);
 
+        std::deque<Scratch> &threadScratch = threadsScratch.Get();
+        if (level == (int)threadScratch.size())
+        {
+            threadScratch.push_back(Scratch());
+        }
+        Scratch &scratch = threadScratch[level];
+        std::vector<MaximalFace> &maximalFaces = scratch.maximalFaces;
+        std::vector<MaximalFacePtr> &Q = scratch.queue;
+        std::vector<MaximalFacePtr> &neighbours = scratch.neighbours;
+        maximalFaces.clear();
+        Q.clear();
+
         IntersectionFlags flag = 1;
-        std::vector<MaximalFacePtr> maximalFaces;
         for (int i = 0; i < lastMaximalFacePower; i++)
         {
             if ((intersectionFlagsMF & flag) != 0)
             {
-                maximalFaces.push_back(new MaximalFace(flag, confToSubconf[flag]));
+                maximalFaces.push_back(MaximalFace(flag, subconfFlags[i]));
             }
             flag = flag << 1;
         }
         if (maximalFaces.size() == 1)
         {
-            Clear(maximalFaces);
             return true;
         }
 
-        std::queue<MaximalFacePtr> Q;
-        MaximalFacePtr mf = maximalFaces[0];
+        // every face is added to the queue at most once (when it is
+        // added to acyclic subset), so vector with moving head is enough
+        int head = 0;
+        MaximalFacePtr mf = &maximalFaces[0];
         mf->isAddedToQueue = true;
-        Q.push(mf);
+        Q.push_back(mf);
         int facesInAccSub = 1;
         mf->isInAccSub = true;
-        UpdateNeighboursAccIntersection(mf, maximalFaces);
-        while (!Q.empty())
+        UpdateNeighboursAccIntersection(mf, scratch);
+        while (head < (int)Q.size())
         {
-            mf = Q.front();
-            Q.pop();
+            mf = Q[head++];
             mf->isAddedToQueue = false;
-            std::vector<MaximalFacePtr> neighbours;
             mf->GetNeighboursNotInAccSub(maximalFaces, neighbours);
             for (typename std::vector<MaximalFacePtr>::iterator n = neighbours.begin(); n != neighbours.end(); n++)
             {
-                if (IsAcyclic(simplex, (*n)->accIntersectionFlags, (*n)->accIntersectionFlagsMF))
+                if (IsAcyclic(simplex, (*n)->accIntersectionFlags, (*n)->accIntersectionFlagsMF, level + 1))
                 {
                     facesInAccSub++;
                     (*n)->isInAccSub = true;
-                    UpdateNeighboursAccIntersection((*n), maximalFaces);
+                    UpdateNeighboursAccIntersection((*n), scratch);
                     if (!(*n)->isAddedToQueue)
                     {
                         (*n)->isAddedToQueue = true;
-                        Q.push(*n);
+                        Q.push_back(*n);
                     }
                 }
             }
         }
 
-        Clear(maximalFaces);
-        return (facesInAccSub == maximalFaces.size());
+        return (facesInAccSub == (int)maximalFaces.size());
     }
 
-    int GetID() { return 3; }
-
-private:
-
-    void UpdateNeighboursAccIntersection(const MaximalFacePtr &face, const std::vector<MaximalFacePtr> &maximalFaces)
+    void UpdateNeighboursAccIntersection(const MaximalFacePtr &face, Scratch &scratch)
     {
-        std::vector<MaximalFacePtr> neighbours;
-        face->GetNeighboursNotInAccSub(maximalFaces, neighbours);
+        std::vector<MaximalFacePtr> &neighbours = scratch.updatedNeighbours;
+        face->GetNeighboursNotInAccSub(scratch.maximalFaces, neighbours);
         for (typename std::vector<MaximalFacePtr>::const_iterator f = neighbours.begin(); f != neighbours.end(); f++)
         {
             if ((*f) == face || (*f)->isInAccSub)
@@ -719,13 +800,13 @@ private:
             {
                 continue;
             }
-            IntersectionFlags flags = 1 << lastMaximalFacePower;
+            IntersectionFlags flags = IntersectionFlagsHelpers<IntersectionFlags>::Bit(lastMaximalFacePower);
             IntersectionFlags intersectionMF = intersection;
-            for (int i = 0; i < lastMaximalFacePower; i++)
+            for (int i = lastMaximalFacePower; i > 0; i--)
             {
                 if ((intersectionMF & flags) != 0)
                 {
-                    IntersectionFlags subconf = confToSubconf[flags];
+                    const IntersectionFlags &subconf = subconfFlags[i];
                     intersectionMF &= (~(subconf & (~flags)));
                 }
                 flags = flags >> 1;
@@ -737,14 +818,6 @@ private:
         }
     }
 
-    void Clear(const std::vector<MaximalFacePtr> &maximalFaces)
-    {
-        for (typename std::vector<MaximalFacePtr>::const_iterator f = maximalFaces.begin(); f != maximalFaces.end(); f++)
-        {
-            delete (*f);
-        }
-    }
-
     void GetNeighboursNotInAccSub(const Simplex &s, const SimplexList &simplexList, const SimplexList &simplicesInAccSub, SimplexList &neighbours)
     {
         if (neighbours.size() > 0)
@@ -795,7 +868,8 @@ class AccTestHomology : public AccTestT<Traits>
     typedef typename Traits::SimplexList SimplexList;
     typedef typename Traits::IntersectionFlags IntersectionFlags;
 
-    std::map<IntersectionFlags, Simplex> simplexMap;
+    // face with flag 1 << i
+    std::vector<Simplex> faces;
     int lastMaximalFacePower;
 
 public:
@@ -804,7 +878,14 @@ public:
     {
         lastMaximalFacePower = (1 << (dim + 1)) - 2;
         ConfigurationsFlags<Simplex, IntersectionFlags> configurationsFlags(dim, false, true);
+        std::map<IntersectionFlags, Simplex> simplexMap;
         configurationsFlags.GetReverseMap(simplexMap);
+        IntersectionFlags flag = 1;
+        for (int i = 0; i < lastMaximalFacePower; i++)
+        {
+            faces.push_back(simplexMap[flag]);
+            flag = flag << 1;
+        }
     }
 
     bool IsAcyclic(const Simplex &simplex, SimplexList &intersectionMF)
@@ -816,19 +897,25 @@ public:
     bool IsAcyclic(const Simplex &simplex, const IntersectionFlags &intersectionFlags, const IntersectionFlags &intersectionFlagsMF)
     {
         TRIVIAL_TEST_F(simplex, intersectionFlags, intersectionFlagsMF);
+        EULER_TEST_F(intersectionFlags);
         IntersectionFlags flag = 1;
         SimplexList simplexList;
         for (int i = 0; i < lastMaximalFacePower; i++)
         {
             if ((intersectionFlagsMF & flag) == flag)
             {
-                simplexList.push_back(simplexMap[flag]);
+                simplexList.push_back(faces[i]);
             }
             flag = flag << 1;
         }
         return HomologyHelper::IsTrivialHomology(simplexList);
     }
 
+    int Decide(const Simplex &simplex, const IntersectionFlags &intersectionFlags, const IntersectionFlags &intersectionFlagsMF)
+    {
+        return IsAcyclic(simplex, intersectionFlags, intersectionFlagsMF) ? 1 : -1;
+    }
+
     int GetID() { return 4; }
 
 };
@@ -842,7 +929,8 @@ class AccTestReductions : public AccTestT<Traits>
     typedef typename Traits::SimplexList SimplexList;
     typedef typename Traits::IntersectionFlags IntersectionFlags;
 
-    std::map<IntersectionFlags, Simplex> simplexMap;
+    // face with flag 1 << i
+    std::vector<Simplex> faces;
     int lastMaximalFacePower;
 
 public:
@@ -851,7 +939,14 @@ public:
     {
         lastMaximalFacePower = (1 << (dim + 1)) - 2;
         ConfigurationsFlags<Simplex, IntersectionFlags> configurationsFlags(dim, false, true);
+        std::map<IntersectionFlags, Simplex> simplexMap;
         configurationsFlags.GetReverseMap(simplexMap);
+        IntersectionFlags flag = 1;
+        for (int i = 0; i < lastMaximalFacePower; i++)
+        {
+            faces.push_back(simplexMap[flag]);
+            flag = flag << 1;
+        }
     }
 
     bool IsAcyclic(const Simplex &simplex, SimplexList &intersectionMF)
@@ -863,13 +958,14 @@ public:
     bool IsAcyclic(const Simplex &simplex, const IntersectionFlags &intersectionFlags, const IntersectionFlags &intersectionFlagsMF)
     {
         TRIVIAL_TEST_F(simplex, intersectionFlags, intersectionFlagsMF);
+        EULER_TEST_F(intersectionFlags);
         IntersectionFlags flag = 1;
         SimplexList simplexList;
         for (int i = 0; i < lastMaximalFacePower; i++)
         {
             if ((intersectionFlagsMF & flag) == flag)
             {
-                simplexList.push_back(simplexMap[flag]);
+                simplexList.push_back(faces[i]);
             }
             flag = flag << 1;
         }
@@ -882,6 +978,172 @@ public:
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// computes reduced homology with Z2 coefficients of the intersection directly
+// on the flags. all faces of given dimension fit in a single 64 bit word, so
+// boundary of every face is precomputed as a word over faces of dimension
+// less by one and ranks of boundary matrices are computed by word-level
+// gaussian elimination on stack arrays. complete test for dim <= 4 (five
+// vertices can not carry torsion), for higher dimensions odd torsion
+// is not detected
+template <typename Traits>
+class AccTestHomologyZ2 : public AccTestT<Traits>
+{
+    typedef typename Traits::Simplex Simplex;
+    typedef typename Traits::SimplexList SimplexList;
+    typedef typename Traits::IntersectionFlags IntersectionFlags;
+    typedef unsigned long long Word;
+
+    static const int MAX_DIM = 6;
+    static const int MAX_FACES = (1 << (MAX_DIM + 1)) - 1;
+    static const int WORD_BITS = 64;
+
+    int facesCount;
+    int firstFace[MAX_DIM + 2];
+    Word boundary[MAX_FACES];
+    std::vector<IntersectionFlags> faceFlags;
+    ConfigurationsFlags<Simplex, IntersectionFlags> subconfigurationsFlags;
+
+public:
+
+    AccTestHomologyZ2(int dim) : AccTestT<Traits>(dim), subconfigurationsFlags(dim, true, true)
+    {
+        if (dim > MAX_DIM)
+        {
+            throw std::string("AccTestHomologyZ2: dim > 6");
+        }
+        facesCount = (1 << (dim + 1)) - 1;
+        firstFace[0] = 0;
+        for (int d = 0; d <= dim; d++)
+        {
+            firstFace[d + 1] = firstFace[d] + IntersectionFlagsHelpers<IntersectionFlags>::PopCount(this->dimensionsMasks[d]);
+        }
+
+        // faces are numbered by positions of their flags
+        ConfigurationsFlags<Simplex, IntersectionFlags> configurationsFlags(dim, false, true);
+        std::map<IntersectionFlags, Simplex> simplexMap;
+        configurationsFlags.GetReverseMap(simplexMap);
+        std::map<Simplex, int> faceIndex;
+        IntersectionFlags flag = 1;
+        for (int i = 0; i < facesCount; i++)
+        {
+            faceFlags.push_back(flag);
+            faceIndex[simplexMap[flag]] = i;
+            flag = flag << 1;
+        }
+        for (int i = 0; i < facesCount; i++)
+        {
+            boundary[i] = 0;
+            const Simplex &s = simplexMap[faceFlags[i]];
+            if (s.size() < 2)
+            {
+                continue;
+            }
+            int d = s.size() - 1;
+            for (int v = 0; v < (int)s.size(); v++)
+            {
+                Simplex face = s;
+                face.erase(face.begin() + v);
+                boundary[i] |= Word(1) << (faceIndex[face] - firstFace[d - 1]);
+            }
+        }
+    }
+
+    bool IsAcyclic(const Simplex &simplex, SimplexList &intersectionMF)
+    {
+        TRIVIAL_TEST_I(simplex, intersectionMF);
+        // we assume that simplices are normalized
+        IntersectionFlags intersectionFlags = 0;
+        for (typename SimplexList::iterator i = intersectionMF.begin(); i != intersectionMF.end(); i++)
+        {
+            intersectionFlags |= subconfigurationsFlags[*i];
+        }
+        return (IsAcyclic(intersectionFlags) > 0);
+    }
+
+    bool IsAcyclic(const Simplex &simplex, const IntersectionFlags &intersectionFlags, const IntersectionFlags &intersectionFlagsMF)
+    {
+        return Decide(simplex, intersectionFlags, intersectionFlagsMF) > 0;
+    }
+
+    int Decide(const Simplex &simplex, const IntersectionFlags &intersectionFlags, const IntersectionFlags &intersectionFlagsMF)
+    {
+        int tt = this->TrivialTest(simplex, intersectionFlags, intersectionFlagsMF);
+        if (tt != 0) return tt;
+        if (this->EulerTest(intersectionFlags) < 0) return -1;
+        return IsAcyclic(intersectionFlags);
+    }
+
+    int GetID() { return 9; }
+
+private:
+
+    // intersectionFlags have to be closed under taking faces
+    int IsAcyclic(const IntersectionFlags &intersectionFlags)
+    {
+        int dim = this->dim;
+        Word faces[MAX_DIM + 1] = { 0 };
+        for (int d = 0; d <= dim; d++)
+        {
+            faces[d] = 0;
+            for (int i = firstFace[d]; i < firstFace[d + 1]; i++)
+            {
+                if ((intersectionFlags & faceFlags[i]) != 0)
+                {
+                    faces[d] |= Word(1) << (i - firstFace[d]);
+                }
+            }
+        }
+        if (faces[0] == 0)
+        {
+            return -1;
+        }
+        // rank of augmentation map
+        int rankPrev = 1;
+        for (int d = 0; d <= dim; d++)
+        {
+            int rankNext = (d < dim) ? BoundaryRank(d + 1, faces[d + 1]) : 0;
+            if (__builtin_popcountll(faces[d]) - rankPrev - rankNext != 0)
+            {
+                return -1;
+            }
+            rankPrev = rankNext;
+        }
+        return 1;
+    }
+
+    int BoundaryRank(int d, Word faces)
+    {
+        // pivots[i] is a reduced row with lowest set bit equal to i
+        Word pivots[WORD_BITS];
+        int rowsLength = firstFace[d] - firstFace[d - 1];
+        for (int i = 0; i < rowsLength; i++)
+        {
+            pivots[i] = 0;
+        }
+        int rank = 0;
+        while (faces != 0)
+        {
+            int f = __builtin_ctzll(faces);
+            faces &= faces - 1;
+            Word row = boundary[firstFace[d] + f];
+            while (row != 0)
+            {
+                int pivot = __builtin_ctzll(row);
+                if (pivots[pivot] == 0)
+                {
+                    pivots[pivot] = row;
+                    rank++;
+                    break;
+                }
+                row ^= pivots[pivot];
+            }
+        }
+        return rank;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 #define ACCTREE_2D  "acctree2d.dat"
 #define ACCTREE_3D  "acctree3d.dat"
 #define ACCTREE_4D  "acctree4d.dat"
@@ -916,7 +1178,7 @@ class AccTestTree : public AccTestT<Traits>
             }
         }
 
-        int IsAcyclic(int dim, std::map<int, int> &facesCount, int lastNonzeroDim, const IntersectionFlags &intersectionFlagsMF)
+        int IsAcyclic(int dim, std::map<int, int> &facesCount, int lastNonzeroDim, const IntersectionFlags &intersectionFlagsMF) const
         {
             if (dim == lastNonzeroDim)
             {
@@ -930,14 +1192,14 @@ class AccTestTree : public AccTestT<Traits>
             }
             else
             {
-                int fc = facesCount[dim + 1];
-                if (nodes[fc] == 0)
+                typename std::map<int, Node*>::const_iterator node = nodes.find(facesCount[dim + 1]);
+                if (node == nodes.end() || node->second == 0)
                 {
                     return -1;
                 }
                 else
                 {
-                    return nodes[fc]->IsAcyclic(dim + 1, facesCount, lastNonzeroDim, intersectionFlagsMF);
+                    return node->second->IsAcyclic(dim + 1, facesCount, lastNonzeroDim, intersectionFlagsMF);
                 }
             }
         }
@@ -1024,8 +1286,6 @@ public:
         }
         rootNode.Read(fp);
         fclose(fp);
-
-        this->CreateFlagsDimensions();
     }
 
     ~AccTestTree()
@@ -1062,41 +1322,29 @@ public:
     }
 
     bool IsAcyclic(const Simplex &simplex, const IntersectionFlags &intersectionFlags, const IntersectionFlags &intersectionFlagsMF)
+    {
+        return Decide(simplex, intersectionFlags, intersectionFlagsMF) > 0;
+    }
+
+    int Decide(const Simplex &simplex, const IntersectionFlags &intersectionFlags, const IntersectionFlags &intersectionFlagsMF)
     {
         std::map<int, int> facesCount;
-        int currentDim = 0;
-        int index = 0;
-        int flags = 1;
-        int count = 0;
         int lastNonzeroDim = 0;
-        while (currentDim < this->dim)
+        for (int d = 0; d < this->dim; d++)
         {
-            if (intersectionFlagsMF & flags)
-            {
-                count++;
-            }
-            flags = flags << 1;
-            index++;
-            while (index >= this->flagsDimensions[currentDim] && currentDim < this->dim)
+            facesCount[d] = this->dimensionsMasks.GetFacesCount(intersectionFlagsMF, d);
+            if (facesCount[d] != 0)
             {
-                facesCount[currentDim] = count;
-                if (count != 0)
-                {
-                    lastNonzeroDim = currentDim;
-                }
-                count = 0;
-                currentDim++;
+                lastNonzeroDim = d;
             }
         }
 
         int res = IsAcyclic(facesCount, lastNonzeroDim, intersectionFlagsMF);
-        if (res == 1) return true;
-        if (res == -1) return false;
-        if (fullTest != 0)
+        if (res == 0 && fullTest != 0)
         {
-            return fullTest->IsAcyclic(simplex, intersectionFlags, intersectionFlagsMF);
+            return fullTest->Decide(simplex, intersectionFlags, intersectionFlagsMF);
         }
-        return false;
+        return res;
     }
 
     int GetID() { return 6; }
@@ -1119,16 +1367,185 @@ private:
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// necessary condition only: rejects intersections with Euler characteristic
+// different than 1 and never accepts non trivial ones. useful as a cheap
+// tier of AccTestCascade
+template <typename Traits>
+class AccTestEuler : public AccTestT<Traits>
+{
+    typedef typename Traits::Simplex Simplex;
+    typedef typename Traits::SimplexList SimplexList;
+    typedef typename Traits::IntersectionFlags IntersectionFlags;
+
+public:
+
+    AccTestEuler(int dim) : AccTestT<Traits>(dim) { }
+
+    bool IsAcyclic(const Simplex &simplex, SimplexList &intersectionMF)
+    {
+        TRIVIAL_TEST_I(simplex, intersectionMF);
+        return false;
+    }
+
+    bool IsAcyclic(const Simplex &simplex, const IntersectionFlags &intersectionFlags, const IntersectionFlags &intersectionFlagsMF)
+    {
+        return Decide(simplex, intersectionFlags, intersectionFlagsMF) > 0;
+    }
+
+    int Decide(const Simplex &simplex, const IntersectionFlags &intersectionFlags, const IntersectionFlags &intersectionFlagsMF)
+    {
+        int tt = this->TrivialTest(simplex, intersectionFlags, intersectionFlagsMF);
+        if (tt != 0) return tt;
+        return this->EulerTest(intersectionFlags);
+    }
+
+    int GetID() { return 7; }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
+// runs tests (tiers) in given order until one of them decides. cheap partial
+// tests should go first and the complete test last, so it is called only
+// for configurations the others could not decide. the order is encoded as
+// decimal digits of the test number, most significant first, e.g. 7124 means
+// Euler, CoDim 1, star and finally CAPD homology. undecided configurations are
+// treated as not acyclic
+template <typename Traits>
+class AccTestCascade : public AccTestT<Traits>
+{
+    typedef typename Traits::Simplex Simplex;
+    typedef typename Traits::SimplexList SimplexList;
+    typedef typename Traits::IntersectionFlags IntersectionFlags;
+
+    int order;
+    std::vector<AccTestT<Traits> *> tiers;
+    // counted separately by each thread and merged in GetStats
+    ThreadsData<AccTestStats> threadsStats;
+    AccTestStats stats;
+
+public:
+
+    static const int DEFAULT_ORDER = 7129;
+
+    AccTestCascade(int order, int dim) : AccTestT<Traits>(dim)
+    {
+        this->order = order;
+        std::vector<int> ids;
+        while (order > 0)
+        {
+            ids.push_back(order % 10);
+            order /= 10;
+        }
+        if (ids.size() < 2)
+        {
+            throw std::string("AccTestCascade: at least two tiers expected");
+        }
+        for (std::vector<int>::reverse_iterator id = ids.rbegin(); id != ids.rend(); id++)
+        {
+            if ((*id) == 7)
+            {
+                tiers.push_back(new AccTestEuler<Traits>(dim));
+            }
+            else if ((*id) < 7 || (*id) == 9)
+            {
+                tiers.push_back(AccTestT<Traits>::Create(*id, dim));
+            }
+            else
+            {
+                throw std::string("AccTestCascade: invalid tier");
+            }
+            stats.AddTier(*id);
+        }
+        threadsStats.SetPrototype(stats);
+    }
+
+    ~AccTestCascade()
+    {
+        for (typename std::vector<AccTestT<Traits> *>::iterator i = tiers.begin(); i != tiers.end(); i++)
+        {
+            delete (*i);
+        }
+    }
+
+    bool IsAcyclic(const Simplex &simplex, SimplexList &intersectionMF)
+    {
+        AccTestStats &stats = threadsStats.Get();
+        stats.TestPerformed();
+        int last = tiers.size() - 1;
+        for (int i = 0; i < last; i++)
+        {
+            if (tiers[i]->IsAcyclic(simplex, intersectionMF))
+            {
+                stats.TierDecision(i, 1);
+                return stats.RecordTest(true);
+            }
+        }
+        stats.FullTestPerformed();
+        bool isAcyclic = tiers[last]->IsAcyclic(simplex, intersectionMF);
+        stats.TierDecision(last, isAcyclic ? 1 : -1);
+        return stats.RecordTest(isAcyclic);
+    }
+
+    bool IsAcyclic(const Simplex &simplex, const IntersectionFlags &intersectionFlags, const IntersectionFlags &intersectionFlagsMF)
+    {
+        return Decide(simplex, intersectionFlags, intersectionFlagsMF) > 0;
+    }
+
+    int Decide(const Simplex &simplex, const IntersectionFlags &intersectionFlags, const IntersectionFlags &intersectionFlagsMF)
+    {
+        AccTestStats &stats = threadsStats.Get();
+        stats.TestPerformed();
+        int last = tiers.size() - 1;
+        for (int i = 0; i <= last; i++)
+        {
+            if (i == last)
+            {
+                stats.FullTestPerformed();
+            }
+            int res = tiers[i]->Decide(simplex, intersectionFlags, intersectionFlagsMF);
+            if (res != 0)
+            {
+                stats.TierDecision(i, res);
+                stats.RecordTest(res > 0);
+                return res;
+            }
+        }
+        stats.TierDecision(last, 0);
+        stats.RecordTest(false);
+        return 0;
+    }
+
+    int GetID() { return order; }
+
+    AccTestStats *GetStats()
+    {
+        stats = AccTestStats();
+        for (typename ThreadsData<AccTestStats>::const_iterator i = threadsStats.begin(); i != threadsStats.end(); i++)
+        {
+            stats.Merge(**i);
+        }
+        return &stats;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 template <typename Traits>
 AccTestT<Traits> *AccTestT<Traits>::Create(int accTestNumber, int dim)
 {
     if (dim < 2) dim = 2;
+    // there are no tabulated configurations for dim > 4
+    if (dim > 4 && (accTestNumber == 0 || accTestNumber == 6)) accTestNumber = 8;
+    if (accTestNumber >= 10) return new AccTestCascade<Traits>(accTestNumber, dim);
     if (accTestNumber == 1) return new AccTestCodim1<Traits>(dim);
     if (accTestNumber == 2) return new AccTestStar<Traits>(dim);
     if (accTestNumber == 3) return new AccTestRecursive<Traits>(dim);
     if (accTestNumber == 4) return new AccTestHomology<Traits, RedHomHelpers>(dim);
     if (accTestNumber == 5) return new AccTestReductions<Traits, RedHomHelpers>(dim);
     if (accTestNumber == 6) return new AccTestTree<Traits>(dim);
+    if (accTestNumber == 7) return new AccTestEuler<Traits>(dim);
+    if (accTestNumber == 8) return new AccTestCascade<Traits>(AccTestCascade<Traits>::DEFAULT_ORDER, dim);
+    if (accTestNumber == 9) return new AccTestHomologyZ2<Traits>(dim);
     return new AccTestTabs<Traits>(dim); // default
 }
 
@@ -58,6 +58,7 @@ public:
             int accTestNumber;
             int accSubAlg;
             simplexData->GetSimplexData(simplexList, borderVerts, accSubAlg, accTestNumber);
+            delete simplexData;
             AccTest *accTest = AccTest::Create(accTestNumber, Simplex::GetSimplexListDimension(simplexList));
 
             IncidenceGraph *ig = 0;
@@ -77,7 +78,6 @@ public:
             node->ig = igData->GetIncidenceGraph(node->simplexPtrList);
 
             delete igData;
-            delete simplexData;
             delete accTest;
 
 #ifdef ACCSUB_TRACE
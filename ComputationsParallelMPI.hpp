@@ -13,7 +13,14 @@
 #define	COMPUTATIONSPARALLELMPI_HPP
 
 #include "IncidenceGraphHelpers.hpp"
+#include "AccSpanningTree.hpp"
+#include "ComputationsLocal.hpp"
+#include <deque>
+#include <vector>
 #include <map>
+#include <set>
+#include <limits>
+#include <algorithm>
 
 #ifdef ACCSUB_TRACE
 #include "Utils.hpp"
@@ -22,6 +29,7 @@
 #ifdef USE_MPI
 #include <mpi.h>
 #include "MPIData.hpp"
+#include "SimplexListBinary.hpp"
 #ifdef DEBUG_MPI
 #include "Utils.hpp"
 #endif
@@ -32,6 +40,11 @@
 #define MPI_MY_DATASIZE_TAG    3
 #define MPI_MY_DATA_TAG        4
 #define MPI_MY_MEMORY_INFO_TAG 5
+#define MPI_MY_KEEP_DATASIZE_TAG 6
+#define MPI_MY_JOIN_TAG        7
+#define MPI_MY_SUMMARY_TAG     8
+#define MPI_MY_LOCAL_INPUT_TAG 9
+#define MPI_MY_FACES_TAG       10
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -47,28 +60,142 @@ class ComputationsParallelMPI
     typedef typename PartitionGraph::Nodes Nodes;
     typedef typename PartitionGraph::AccTest AccTest;
     typedef typename PartitionGraph::AccSubAlgorithm AccSubAlgorithm;
+    typedef typename IncidenceGraph::VertsSet VertsSet;
+    typedef typename IncidenceGraph::Path Path;
+    typedef AccSpanningTreeT<PartitionGraph> AccSpanningTree;
+    typedef typename AccSpanningTree::Node AccSpanningTreeNode;
 
     static AccSubAlgorithm accSubAlgorithm;
     static AccTest *accTest;
 
-    static void SendMPISimplexData(Node *node, int processRank)
-    {
 #ifdef USE_MPI
+    // task sent to slave, packed data is kept until sending is completed
+    struct MPITask
+    {
+        Node                            *node;
+        MPISimplexData<IncidenceGraph>  *data;
+        int                             dataSize;
+        MPI_Request                     requests[2];
+    };
+
+    static MPITask *PackMPITask(Node *node)
+    {
 #ifdef DEBUG_MPI
         std::cout<<"process 0 ";
         Timer::TimeStamp("packing data");
 #endif
-        MPISimplexData<IncidenceGraph> *data = new MPISimplexData<IncidenceGraph>(node->simplexPtrList, node->borderVerts, accSubAlgorithm, accTest->GetID(), Simplex::GetSimplexListConstantSize(node->simplexPtrList));
-        int dataSize = data->GetSize();
-        MPI_Send(&dataSize, 1, MPI_INT, processRank, MPI_MY_DATASIZE_TAG, MPI_COMM_WORLD);
+        MPITask *task = new MPITask();
+        task->node = node;
+        task->data = new MPISimplexData<IncidenceGraph>(node->simplexPtrList, node->borderVerts, accSubAlgorithm, accTest->GetID(), Simplex::GetSimplexListConstantSize(node->simplexPtrList));
+        task->dataSize = task->data->GetSize();
+        return task;
+    }
+
+    // if keep is set slave keeps computed graph and sends back only
+    // description of its connected components
+    static void SendMPITask(MPITask *task, int processRank, bool keep)
+    {
 #ifdef DEBUG_MPI
         std::cout<<"process 0 ";
         Timer::TimeStamp("sending data");
 #endif
-        MPI_Send(data->GetBuffer(), dataSize, MPI_INT, processRank, MPI_MY_WORK_TAG, MPI_COMM_WORLD);
-        delete data;
+        task->node->processRank = processRank;
+        MPI_Isend(&task->dataSize, 1, MPI_INT, processRank, keep ? MPI_MY_KEEP_DATASIZE_TAG : MPI_MY_DATASIZE_TAG, MPI_COMM_WORLD, &task->requests[0]);
+        MPI_Isend(task->data->GetBuffer(), task->dataSize, MPI_INT, processRank, MPI_MY_WORK_TAG, MPI_COMM_WORLD, &task->requests[1]);
+    }
+
+    static void DeleteMPITask(MPITask *task)
+    {
+        MPI_Waitall(2, task->requests, MPI_STATUSES_IGNORE);
+        delete task->data;
+        delete task;
+    }
+
+    // every slave has two tasks sent: the one being computed and the next
+    // one, so it can start computing right after sending results. next
+    // task is packed in advance and received results are unpacked after
+    // new task is sent, so slaves do not wait for master
+    static void ComputeTasks(Nodes &nodes, bool keep)
+    {
+        int nodesCount = nodes.size();
+        int currentNode = 0;
+        int tasksCount;
+        MPI_Status status;
+
+        MPI_Comm_size(MPI_COMM_WORLD, &tasksCount);
+
+        int slavesCount = (tasksCount - 1 < nodesCount) ? (tasksCount - 1) : nodesCount;
+        // without slaves (single process) packs are computed by master,
+        // kept packs always have slaves (see ComputeDistributed)
+        if (slavesCount == 0)
+        {
+            for (typename Nodes::iterator i = nodes.begin(); i != nodes.end(); i++)
+            {
+                ComputationsLocal<PartitionGraph>::CreateIncidenceGraph(*i, accSubAlgorithm, accTest);
+            }
+            return;
+        }
+        std::vector<std::deque<MPITask *> > slavesTasks(slavesCount + 1);
+        std::vector<int> resultsSizes(slavesCount + 1);
+        std::vector<MPI_Request> resultsRequests(slavesCount, MPI_REQUEST_NULL);
+        MPITask *nextTask = PackMPITask(nodes[currentNode]);
+
+        // first every slave gets a task to compute, then a task to prefetch
+        for (int i = 0; i < 2 * slavesCount && currentNode < nodesCount; i++)
+        {
+            int rank = (i % slavesCount) + 1;
+            std::cout<<"sending node "<<currentNode<<" to process: "<<rank<<std::endl;
+            SendMPITask(nextTask, rank, keep);
+            slavesTasks[rank].push_back(nextTask);
+            nextTask = (++currentNode < nodesCount) ? PackMPITask(nodes[currentNode]) : 0;
+        }
+        for (int rank = 1; rank <= slavesCount; rank++)
+        {
+            MPI_Irecv(&resultsSizes[rank], 1, MPI_INT, rank, MPI_MY_DATASIZE_TAG, MPI_COMM_WORLD, &resultsRequests[rank - 1]);
+        }
+
+        // then we wait for any slave to finish and send it next task
+        int pendingTasks = currentNode;
+        while (pendingTasks > 0)
+        {
+            int index;
+            MPI_Waitany(slavesCount, &resultsRequests[0], &index, &status);
+            int rank = index + 1;
+            int dataSize = resultsSizes[rank];
+            int *buffer = new int[dataSize];
+            MPI_Recv(buffer, dataSize, MPI_INT, rank, MPI_MY_DATA_TAG, MPI_COMM_WORLD, &status);
+#ifdef DEBUG_MPI
+            std::cout<<"process 0 ";
+            Timer::TimeStamp("received data");
 #endif
+            MPITask *task = slavesTasks[rank].front();
+            slavesTasks[rank].pop_front();
+            if (nextTask != 0)
+            {
+                std::cout<<"sending node "<<currentNode<<" to process: "<<rank<<std::endl;
+                SendMPITask(nextTask, rank, keep);
+                slavesTasks[rank].push_back(nextTask);
+                nextTask = (++currentNode < nodesCount) ? PackMPITask(nodes[currentNode]) : 0;
+                pendingTasks++;
+            }
+            if (slavesTasks[rank].size() > 0)
+            {
+                MPI_Irecv(&resultsSizes[rank], 1, MPI_INT, rank, MPI_MY_DATASIZE_TAG, MPI_COMM_WORLD, &resultsRequests[index]);
+            }
+            if (keep)
+            {
+                // slave keeps the graph, only number of components is sent
+                delete [] buffer;
+            }
+            else
+            {
+                SetMPIIncidenceGraphData(task->node, buffer, dataSize);
+            }
+            DeleteMPITask(task);
+            pendingTasks--;
+        }
     }
+#endif
 
     static void SetMPIIncidenceGraphData(Node *node, int *buffer, int size)
     {
@@ -83,8 +210,762 @@ class ComputationsParallelMPI
 #endif
     }
 
+#ifdef USE_MPI
+    // pack computed by slave and kept until reduced graph is gathered.
+    // components are nodes of spanning tree (see JoinKeptPacks), paths
+    // are stored by indices of spanning tree edges
+    struct KeptPack
+    {
+        SimplexList                             simplexList;
+        Node                                    *node;
+        int                                     index;
+        std::vector<AccSpanningTreeNode *>      components;
+        std::map<int, Path>                     paths;
+        std::map<Vertex, std::vector<typename IncidenceGraph::Node *> > borderNodes;
+        // removed components without acyclic subset in their trees:
+        // count, then tree id, simplices count and their indices in pack
+        std::vector<int>                        isolated;
+
+        KeptPack()
+        {
+            node = new Node();
+            index = -1;
+            isolated.push_back(0);
+        }
+
+        ~KeptPack()
+        {
+            for (typename std::vector<AccSpanningTreeNode *>::iterator i = components.begin(); i != components.end(); i++)
+            {
+                delete (*i);
+            }
+            delete node;
+        }
+
+        // simplices containing border vertices, indexed when first
+        // faces from other packs are received (after isolated components
+        // are removed)
+        std::vector<typename IncidenceGraph::Node *> &GetBorderNodes(Vertex v)
+        {
+            if (borderNodes.size() == 0)
+            {
+                IncidenceGraph *ig = node->ig;
+                for (typename IncidenceGraph::Nodes::iterator i = ig->nodes.begin(); i != ig->nodes.end(); i++)
+                {
+                    if (!(*i)->IsOnBorder())
+                    {
+                        continue;
+                    }
+                    for (typename Simplex::iterator sv = (*i)->simplex->begin(); sv != (*i)->simplex->end(); sv++)
+                    {
+                        if (ig->borderVerts.find(*sv) != ig->borderVerts.end())
+                        {
+                            borderNodes[*sv].push_back(*i);
+                        }
+                    }
+                }
+            }
+            return borderNodes[v];
+        }
+
+        // faces (pairs of vertices) added to acyclic subset of other pack
+        // update simplices containing them, as they would be updated
+        // through incidence graph edges if graphs were combined
+        void AddFaces(const int *faces, int count)
+        {
+            for (int i = 0; i < count; i += 2)
+            {
+                Vertex v1 = faces[i];
+                Vertex v2 = faces[i + 1];
+                for (int j = 0; j < 2; j++)
+                {
+                    std::vector<typename IncidenceGraph::Node *> &nodes = GetBorderNodes(j == 0 ? v1 : v2);
+                    for (typename std::vector<typename IncidenceGraph::Node *>::iterator node = nodes.begin(); node != nodes.end(); node++)
+                    {
+                        Simplex face;
+                        for (typename Simplex::iterator v = (*node)->simplex->begin(); v != (*node)->simplex->end(); v++)
+                        {
+                            if (*v == v1 || *v == v2)
+                            {
+                                face.push_back(*v);
+                            }
+                        }
+                        (*node)->GetAccInfo().UpdateAccIntersection(face);
+                    }
+                }
+            }
+        }
+    };
+
+    typedef std::vector<KeptPack *> KeptPacks;
+
+    static void KeepPack(KeptPacks &keptPacks, KeptPack *pack, IncidenceGraph *ig)
+    {
+        // paths connecting acyclic subsets are searched in the rest of graph
+        ig->RemoveAccSub();
+        pack->node->ig = ig;
+        for (int i = 0; i < (int)ig->connectedComponents.size(); i++)
+        {
+            pack->components.push_back(new AccSpanningTreeNode(pack->node, i + 1, ig->connectedComponents[i], ig->connectedComponentsBorders[i], ig->connectedComponentsAccSubSize[i]));
+        }
+        keptPacks.push_back(pack);
+    }
+
+    // every process (master with no packs) has its own copy of the state.
+    // ranks of packs, neighbourhood of packs, sizes of acyclic subsets
+    // and spanning tree are known to all of them, borders and paths only
+    // to processes keeping the packs and their neighbours
+    struct JoinState
+    {
+        int                                     processRank;
+        std::vector<int>                        packsRanks;
+        std::vector<std::vector<int> >          packsNeighbours;
+        // ranks of neighbouring packs other than rank of the pack
+        std::vector<std::vector<int> >          packsNeighboursRanks;
+        std::map<int, KeptPack *>               packs;
+        // components of pack i have ids componentsOffsets[i] + 1, ...
+        std::vector<int>                        componentsOffsets;
+        std::vector<int>                        componentsPacks;
+        std::vector<int>                        accSubSizes;
+        std::vector<int>                        parents;
+        std::vector<int>                        treesAccSubSizes;
+        // edges of own components, keys give the same order as
+        // edges of AccSpanningTree
+        std::map<int, std::vector<long long> >  componentsEdges;
+        std::map<long long, Vertex>             edgesVerts;
+        std::vector<long long>                  treeEdges;
+
+        int GetComponentsCount()
+        {
+            return componentsOffsets.back();
+        }
+
+        long long GetEdgeKey(int idA, int idB)
+        {
+            return (idA < idB) ? (long long)idA * (GetComponentsCount() + 1) + idB : GetEdgeKey(idB, idA);
+        }
+
+        void GetEdgeIDs(long long key, int &idA, int &idB)
+        {
+            idA = key / (GetComponentsCount() + 1);
+            idB = key % (GetComponentsCount() + 1);
+        }
+
+        bool IsOwnComponent(int id)
+        {
+            return (packsRanks[componentsPacks[id]] == processRank);
+        }
+
+        KeptPack *GetPack(int id)
+        {
+            return packs[componentsPacks[id]];
+        }
+
+        AccSpanningTreeNode *GetComponent(int id)
+        {
+            return GetPack(id)->components[id - componentsOffsets[componentsPacks[id]] - 1];
+        }
+
+        bool IsTreeJoined(int id)
+        {
+            return (treesAccSubSizes[AccSpanningTree::FindRoot(parents, id)] > 0);
+        }
+
+        bool IsNeighbourRank(int pack, int rank)
+        {
+            return std::binary_search(packsNeighboursRanks[pack].begin(), packsNeighboursRanks[pack].end(), rank);
+        }
+    };
+
+    // packs info broadcast by master: packs count, rank of every pack,
+    // count of pairs of neighbouring packs and the pairs
+    static void ReadPacksInfo(JoinState &state, KeptPacks &keptPacks, std::vector<int> &packsInfo)
+    {
+        int index = 0;
+        int packsCount = packsInfo[index++];
+        state.packsRanks.assign(packsInfo.begin() + index, packsInfo.begin() + index + packsCount);
+        index += packsCount;
+        state.packsNeighbours.resize(packsCount);
+        int edgesCount = packsInfo[index++];
+        for (int i = 0; i < edgesCount; i++, index += 2)
+        {
+            state.packsNeighbours[packsInfo[index]].push_back(packsInfo[index + 1]);
+            state.packsNeighbours[packsInfo[index + 1]].push_back(packsInfo[index]);
+        }
+        assert(index == (int)packsInfo.size());
+        state.packsNeighboursRanks.resize(packsCount);
+        for (int i = 0; i < packsCount; i++)
+        {
+            std::set<int> ranks;
+            for (std::vector<int>::iterator n = state.packsNeighbours[i].begin(); n != state.packsNeighbours[i].end(); n++)
+            {
+                ranks.insert(state.packsRanks[*n]);
+            }
+            ranks.erase(state.packsRanks[i]);
+            state.packsNeighboursRanks[i].assign(ranks.begin(), ranks.end());
+        }
+        // packs are sent in order, so they are kept in the same order
+        typename KeptPacks::iterator pack = keptPacks.begin();
+        for (int i = 0; i < packsCount; i++)
+        {
+            if (state.packsRanks[i] == state.processRank)
+            {
+                assert(pack != keptPacks.end());
+                (*pack)->index = i;
+                state.packs[i] = *pack;
+                pack++;
+            }
+        }
+        assert(pack == keptPacks.end());
+    }
+
+    // ids are given to components in order of packs, like in
+    // AccSpanningTree, sizes of acyclic subsets are shared by all
+    static void CreateComponents(JoinState &state)
+    {
+        int packsCount = state.packsRanks.size();
+        std::vector<int> componentsCounts(packsCount, 0);
+        for (typename std::map<int, KeptPack *>::iterator pack = state.packs.begin(); pack != state.packs.end(); pack++)
+        {
+            componentsCounts[pack->first] = pack->second->components.size();
+        }
+        MPI_Allreduce(MPI_IN_PLACE, &componentsCounts[0], packsCount, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+        state.componentsOffsets.assign(packsCount + 1, 0);
+        for (int i = 0; i < packsCount; i++)
+        {
+            state.componentsOffsets[i + 1] = state.componentsOffsets[i] + componentsCounts[i];
+        }
+        int count = state.GetComponentsCount();
+        state.componentsPacks.assign(count + 1, -1);
+        for (int i = 0; i < packsCount; i++)
+        {
+            for (int j = 0; j < componentsCounts[i]; j++)
+            {
+                state.componentsPacks[state.componentsOffsets[i] + j + 1] = i;
+            }
+        }
+        state.accSubSizes.assign(count + 1, 0);
+        for (typename std::map<int, KeptPack *>::iterator pack = state.packs.begin(); pack != state.packs.end(); pack++)
+        {
+            std::vector<AccSpanningTreeNode *> &components = pack->second->components;
+            for (int j = 0; j < (int)components.size(); j++)
+            {
+                components[j]->subtreeID = state.componentsOffsets[pack->first] + j + 1;
+                state.accSubSizes[components[j]->subtreeID] = components[j]->accSubSize;
+            }
+        }
+        MPI_Allreduce(MPI_IN_PLACE, &state.accSubSizes[0], count + 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    }
+
+    // borders of components are sent directly to processes keeping
+    // neighbouring packs: pack index, components count and border of
+    // every component. then edges of own components are created
+    static void ExchangeSummaries(JoinState &state)
+    {
+        std::map<int, std::vector<VertsSet> > borders;
+        std::map<int, std::vector<int> > summaries;
+        for (typename std::map<int, KeptPack *>::iterator pack = state.packs.begin(); pack != state.packs.end(); pack++)
+        {
+            std::vector<AccSpanningTreeNode *> &components = pack->second->components;
+            for (typename std::vector<AccSpanningTreeNode *>::iterator c = components.begin(); c != components.end(); c++)
+            {
+                borders[pack->first].push_back((*c)->borderVerts);
+            }
+            std::vector<int> &ranks = state.packsNeighboursRanks[pack->first];
+            for (std::vector<int>::iterator rank = ranks.begin(); rank != ranks.end(); rank++)
+            {
+                std::vector<int> &summary = summaries[*rank];
+                summary.push_back(pack->first);
+                summary.push_back(components.size());
+                for (typename std::vector<AccSpanningTreeNode *>::iterator c = components.begin(); c != components.end(); c++)
+                {
+                    summary.push_back((*c)->borderVerts.size());
+                    summary.insert(summary.end(), (*c)->borderVerts.begin(), (*c)->borderVerts.end());
+                }
+            }
+        }
+        std::vector<MPI_Request> requests;
+        for (std::map<int, std::vector<int> >::iterator summary = summaries.begin(); summary != summaries.end(); summary++)
+        {
+            requests.push_back(MPI_REQUEST_NULL);
+            MPI_Isend(&summary->second[0], summary->second.size(), MPI_INT, summary->first, MPI_MY_SUMMARY_TAG, MPI_COMM_WORLD, &requests.back());
+        }
+        // neighbourhood of packs is symmetric, so summaries are received
+        // from the same processes they were sent to
+        for (std::map<int, std::vector<int> >::iterator summary = summaries.begin(); summary != summaries.end(); summary++)
+        {
+            MPI_Status status;
+            int size;
+            MPI_Probe(summary->first, MPI_MY_SUMMARY_TAG, MPI_COMM_WORLD, &status);
+            MPI_Get_count(&status, MPI_INT, &size);
+            std::vector<int> buffer(size);
+            MPI_Recv(&buffer[0], size, MPI_INT, summary->first, MPI_MY_SUMMARY_TAG, MPI_COMM_WORLD, &status);
+            int index = 0;
+            while (index < size)
+            {
+                std::vector<VertsSet> &packBorders = borders[buffer[index++]];
+                int componentsCount = buffer[index++];
+                for (int i = 0; i < componentsCount; i++)
+                {
+                    int borderSize = buffer[index++];
+                    packBorders.push_back(VertsSet(buffer.begin() + index, buffer.begin() + index + borderSize));
+                    index += borderSize;
+                }
+            }
+        }
+        MPI_Waitall(requests.size(), requests.size() > 0 ? &requests[0] : 0, MPI_STATUSES_IGNORE);
+
+        // edge vertex is the smallest shared vertex, the same for both
+        // ends of an edge
+        for (typename std::map<int, KeptPack *>::iterator pack = state.packs.begin(); pack != state.packs.end(); pack++)
+        {
+            std::vector<int> &neighbours = state.packsNeighbours[pack->first];
+            for (std::vector<int>::iterator neighbour = neighbours.begin(); neighbour != neighbours.end(); neighbour++)
+            {
+                std::vector<VertsSet> &neighbourBorders = borders[*neighbour];
+                for (typename std::vector<AccSpanningTreeNode *>::iterator c = pack->second->components.begin(); c != pack->second->components.end(); c++)
+                {
+                    for (int i = 0; i < (int)neighbourBorders.size(); i++)
+                    {
+                        Simplex intersection;
+                        GetSortedIntersectionOfUnsortedSets(intersection, (*c)->borderVerts, neighbourBorders[i]);
+                        if (intersection.size() > 0)
+                        {
+                            long long key = state.GetEdgeKey((*c)->subtreeID, state.componentsOffsets[*neighbour] + i + 1);
+                            state.componentsEdges[(*c)->subtreeID].push_back(key);
+                            state.edgesVerts[key] = intersection.front();
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // Boruvka rounds: every process finds cheapest outgoing edges of trees
+    // from edges of its components and minimum is reduced over processes.
+    // with distinct costs (edge keys) the forest is the same as the one
+    // built sequentially by AccSpanningTree
+    static void CreateSpanningTree(JoinState &state)
+    {
+        int count = state.GetComponentsCount();
+        const long long noEdge = std::numeric_limits<long long>::max();
+        state.parents.resize(count + 1);
+        for (int i = 0; i <= count; i++)
+        {
+            state.parents[i] = i;
+        }
+        std::vector<long long> cheapest(count + 1);
+        bool merged = true;
+        while (merged)
+        {
+            std::fill(cheapest.begin(), cheapest.end(), noEdge);
+            for (std::map<int, std::vector<long long> >::iterator c = state.componentsEdges.begin(); c != state.componentsEdges.end(); c++)
+            {
+                int root = AccSpanningTree::FindRoot(state.parents, c->first);
+                for (std::vector<long long>::iterator edge = c->second.begin(); edge != c->second.end(); edge++)
+                {
+                    int idA, idB;
+                    state.GetEdgeIDs(*edge, idA, idB);
+                    if (*edge < cheapest[root] && AccSpanningTree::FindRoot(state.parents, idA) != AccSpanningTree::FindRoot(state.parents, idB))
+                    {
+                        cheapest[root] = *edge;
+                    }
+                }
+            }
+            MPI_Allreduce(MPI_IN_PLACE, &cheapest[0], count + 1, MPI_LONG_LONG_INT, MPI_MIN, MPI_COMM_WORLD);
+            // every process merges trees in the same order
+            merged = false;
+            for (int i = 0; i <= count; i++)
+            {
+                if (cheapest[i] == noEdge)
+                {
+                    continue;
+                }
+                int idA, idB;
+                state.GetEdgeIDs(cheapest[i], idA, idB);
+                int rootA = AccSpanningTree::FindRoot(state.parents, idA);
+                int rootB = AccSpanningTree::FindRoot(state.parents, idB);
+                if (rootA != rootB)
+                {
+                    state.parents[rootB] = rootA;
+                    state.treeEdges.push_back(cheapest[i]);
+                    merged = true;
+                }
+            }
+        }
+        std::sort(state.treeEdges.begin(), state.treeEdges.end());
+        state.treesAccSubSizes.assign(count + 1, 0);
+        for (int i = 1; i <= count; i++)
+        {
+            state.treesAccSubSizes[AccSpanningTree::FindRoot(state.parents, i)] += state.accSubSizes[i];
+        }
+    }
+
+    // trees without acyclic subset are connected components of whole
+    // complex, they are removed from packs and computed separately
+    static void RemoveIsolatedComponents(JoinState &state)
+    {
+        for (typename std::map<int, KeptPack *>::iterator p = state.packs.begin(); p != state.packs.end(); p++)
+        {
+            KeptPack *pack = p->second;
+            for (typename std::vector<AccSpanningTreeNode *>::iterator node = pack->components.begin(); node != pack->components.end(); node++)
+            {
+                if (state.IsTreeJoined((*node)->subtreeID))
+                {
+                    continue;
+                }
+                SimplexPtrList simplexPtrList;
+                pack->node->ig->RemoveConnectedComponentAndCopySimplexList((*node)->connectedComponent, simplexPtrList);
+                pack->isolated[0]++;
+                pack->isolated.push_back(AccSpanningTree::FindRoot(state.parents, (*node)->subtreeID));
+                pack->isolated.push_back(simplexPtrList.size());
+                for (typename SimplexPtrList::iterator s = simplexPtrList.begin(); s != simplexPtrList.end(); s++)
+                {
+                    pack->isolated.push_back((*s) - &pack->simplexList.front());
+                }
+                delete (*node);
+                (*node) = 0;
+            }
+        }
+    }
+
+    // paths are found before any of them is added
+    static void FindPaths(JoinState &state)
+    {
+        for (int i = 0; i < (int)state.treeEdges.size(); i++)
+        {
+            int ids[2];
+            state.GetEdgeIDs(state.treeEdges[i], ids[0], ids[1]);
+            if (!state.IsTreeJoined(ids[0]))
+            {
+                continue;
+            }
+            for (int j = 0; j < 2; j++)
+            {
+                if (state.IsOwnComponent(ids[j]))
+                {
+                    state.GetComponent(ids[j])->FindAccSubToBorderConnection(state.edgesVerts[state.treeEdges[i]], state.GetPack(ids[j])->paths[i]);
+                }
+            }
+        }
+        for (typename std::map<int, KeptPack *>::iterator pack = state.packs.begin(); pack != state.packs.end(); pack++)
+        {
+            for (typename std::vector<AccSpanningTreeNode *>::iterator node = pack->second->components.begin(); node != pack->second->components.end(); node++)
+            {
+                if (*node != 0)
+                {
+                    (*node)->FindBoundaryVertsConnectingPaths();
+                }
+            }
+        }
+    }
+
+    // faces sent by process keeping the pack updated in given step
+    static void ReceiveFaces(JoinState &state, std::deque<std::pair<int, int> > &expectedFaces)
+    {
+        while (expectedFaces.size() > 0)
+        {
+            int rank = expectedFaces.front().first;
+            MPI_Status status;
+            int size;
+            MPI_Probe(rank, MPI_MY_FACES_TAG, MPI_COMM_WORLD, &status);
+            MPI_Get_count(&status, MPI_INT, &size);
+            std::vector<int> faces(size);
+            MPI_Recv(&faces[0], size, MPI_INT, rank, MPI_MY_FACES_TAG, MPI_COMM_WORLD, &status);
+            assert(faces[0] == expectedFaces.front().second);
+            for (typename std::map<int, KeptPack *>::iterator pack = state.packs.begin(); pack != state.packs.end(); pack++)
+            {
+                pack->second->AddFaces(&faces[1], size - 1);
+            }
+            expectedFaces.pop_front();
+        }
+    }
+
+    // paths are added in the same order as in AccSpanningTree::JoinAccSubsets,
+    // which every process knows. each path is added by process keeping
+    // the component, faces added on border of the pack are sent directly
+    // to processes keeping neighbouring packs. they are applied before
+    // next path is added by receiving process, so the result is the same
+    // as if graphs were joined by one process
+    static void AddPaths(JoinState &state)
+    {
+        std::vector<char> connected(state.GetComponentsCount() + 1, 0);
+        std::deque<std::pair<int, int> > expectedFaces;
+        std::deque<std::vector<int> > sentFaces;
+        std::vector<MPI_Request> requests;
+        int step = 0;
+        for (int i = 0; i < (int)state.treeEdges.size(); i++)
+        {
+            int ids[2];
+            state.GetEdgeIDs(state.treeEdges[i], ids[0], ids[1]);
+            if (!state.IsTreeJoined(ids[0]))
+            {
+                continue;
+            }
+            if (!connected[ids[0]])
+            {
+                std::swap(ids[0], ids[1]);
+            }
+            for (int j = 0; j < 2; j++, step++)
+            {
+                int id = ids[j];
+                // component without acyclic subset adds its paths only once
+                if (state.accSubSizes[id] == 0 && connected[id])
+                {
+                    continue;
+                }
+                connected[id] = 1;
+                int packIndex = state.componentsPacks[id];
+                if (state.packsRanks[packIndex] != state.processRank)
+                {
+                    if (state.IsNeighbourRank(packIndex, state.processRank))
+                    {
+                        expectedFaces.push_back(std::pair<int, int>(state.packsRanks[packIndex], step));
+                    }
+                    continue;
+                }
+                ReceiveFaces(state, expectedFaces);
+                KeptPack *pack = state.GetPack(id);
+                AccSpanningTreeNode *node = state.GetComponent(id);
+                std::vector<std::pair<Vertex, Vertex> > addedEdges;
+                node->addedEdges = &addedEdges;
+                node->UpdateAccSubToBorderConnection(state.edgesVerts[state.treeEdges[i]], pack->paths[i]);
+                node->addedEdges = 0;
+                // only faces with border vertices can be shared with other packs
+                sentFaces.push_back(std::vector<int>(1, step));
+                std::vector<int> &faces = sentFaces.back();
+                VertsSet &borderVerts = pack->node->ig->borderVerts;
+                for (typename std::vector<std::pair<Vertex, Vertex> >::iterator e = addedEdges.begin(); e != addedEdges.end(); e++)
+                {
+                    if (borderVerts.find(e->first) != borderVerts.end() || borderVerts.find(e->second) != borderVerts.end())
+                    {
+                        faces.push_back(e->first);
+                        faces.push_back(e->second);
+                    }
+                }
+                for (typename std::map<int, KeptPack *>::iterator p = state.packs.begin(); p != state.packs.end(); p++)
+                {
+                    if (p->second != pack)
+                    {
+                        p->second->AddFaces(&faces[1], faces.size() - 1);
+                    }
+                }
+                std::vector<int> &ranks = state.packsNeighboursRanks[packIndex];
+                for (std::vector<int>::iterator rank = ranks.begin(); rank != ranks.end(); rank++)
+                {
+                    requests.push_back(MPI_REQUEST_NULL);
+                    MPI_Isend(&faces[0], faces.size(), MPI_INT, *rank, MPI_MY_FACES_TAG, MPI_COMM_WORLD, &requests.back());
+                }
+            }
+        }
+        ReceiveFaces(state, expectedFaces);
+        MPI_Waitall(requests.size(), requests.size() > 0 ? &requests[0] : 0, MPI_STATUSES_IGNORE);
+    }
+
+    // called by all processes, master takes part in collective
+    // operations only
+    static void JoinKeptPacks(KeptPacks &keptPacks, std::vector<int> &packsInfo, int processRank)
+    {
+        JoinState state;
+        state.processRank = processRank;
+        ReadPacksInfo(state, keptPacks, packsInfo);
+        CreateComponents(state);
+        ExchangeSummaries(state);
+        CreateSpanningTree(state);
+        RemoveIsolatedComponents(state);
+        FindPaths(state);
+        AddPaths(state);
+    }
+
+    // for every pack in order: isolated components and reduced graph
+    static void SendKeptPacks(KeptPacks &keptPacks)
+    {
+        for (typename KeptPacks::iterator pack = keptPacks.begin(); pack != keptPacks.end(); pack++)
+        {
+            int isolatedSize = (*pack)->isolated.size();
+            MPI_Send(&isolatedSize, 1, MPI_INT, 0, MPI_MY_DATASIZE_TAG, MPI_COMM_WORLD);
+            MPI_Send(&(*pack)->isolated[0], isolatedSize, MPI_INT, 0, MPI_MY_DATA_TAG, MPI_COMM_WORLD);
+            IncidenceGraph *ig = (*pack)->node->ig;
+            // components are not needed after joining acyclic subsets
+            // (some of them could have been removed as isolated)
+            ig->connectedComponents.clear();
+            ig->connectedComponentsBorders.clear();
+            ig->connectedComponentsAccSubSize.clear();
+            ig->AssignNewIndices(true);
+            MPIIncidenceGraphData<IncidenceGraph> *igData = new MPIIncidenceGraphData<IncidenceGraph>(ig);
+            int igDataSize = igData->GetSize();
+            MPI_Send(&igDataSize, 1, MPI_INT, 0, MPI_MY_DATASIZE_TAG, MPI_COMM_WORLD);
+            MPI_Send(igData->GetBuffer(), igDataSize, MPI_INT, 0, MPI_MY_DATA_TAG, MPI_COMM_WORLD);
+            delete igData;
+            delete (*pack);
+        }
+        keptPacks.clear();
+    }
+
+    static IncidenceGraph *CreateIncidenceGraph(SimplexList &simplexList, std::set<Vertex> &borderVerts, int accSubAlgorithm, int accTestNumber)
+    {
+        AccTest *accTest = AccTest::Create(accTestNumber, Simplex::GetSimplexListDimension(simplexList));
+        IncidenceGraph *ig = 0;
+        if (accSubAlgorithm == AccSubAlgorithm::AccSubIG)
+        {
+            ig = IncidenceGraphHelpers<IncidenceGraph>::CreateAndCalculateAccSubIGWithBorder(simplexList, borderVerts, accTest);
+        }
+        else
+        {
+            ig = IncidenceGraphHelpers<IncidenceGraph>::CreateAndCalculateAccSubSTWithBorder(simplexList, borderVerts, accTest);
+        }
+        ig->UpdateConnectedComponents();
+        delete accTest;
+        return ig;
+    }
+
+    // slave gets ranges and borders of all packs, computes packs assigned
+    // to it (see ComputeLocalInput) and for every pack sends simplices
+    // of reduced graph followed by the graph
+    static void ComputeLocalInputPacks(int processRank, int dataSize)
+    {
+        int *buffer = new int[dataSize];
+        MPI_Bcast(buffer, dataSize, MPI_INT, 0, MPI_COMM_WORLD);
+        MPILocalInputData<IncidenceGraph> *data = new MPILocalInputData<IncidenceGraph>(buffer, dataSize);
+        std::string filename;
+        int accSubAlgorithm;
+        int accTestNumber;
+        data->GetHeader(filename, accSubAlgorithm, accTestNumber);
+        int tasksCount;
+        MPI_Comm_size(MPI_COMM_WORLD, &tasksCount);
+        std::vector<std::pair<int, int> > ranges;
+        std::vector<std::set<Vertex> > borders;
+        data->GetPacks(processRank - 1, tasksCount - 1, ranges, borders);
+        delete data;
+
+        for (int i = 0; i < (int)ranges.size(); i++)
+        {
+            SimplexList simplexList;
+            SimplexListBinary<Simplex>::Read(simplexList, filename.c_str(), std::vector<std::pair<int, int> >(1, ranges[i]));
+            IncidenceGraph *ig = CreateIncidenceGraph(simplexList, borders[i], accSubAlgorithm, accTestNumber);
+            ig->AssignNewIndices(true);
+            // master does not know simplices, they are sent in order
+            // of new indices of nodes
+            SimplexPtrList simplexPtrList;
+            for (typename IncidenceGraph::Nodes::iterator node = ig->nodes.begin(); node != ig->nodes.end(); node++)
+            {
+                if (!(*node)->IsInAccSub())
+                {
+                    simplexPtrList.push_back((*node)->simplex);
+                    (*node)->helpers.i = (*node)->index;
+                }
+            }
+            int simplexSize = (simplexPtrList.size() > 0) ? Simplex::GetSimplexListConstantSize(simplexPtrList) : 0;
+            MPISimplexData<IncidenceGraph> *simplexData = new MPISimplexData<IncidenceGraph>(simplexPtrList, std::set<Vertex>(), accSubAlgorithm, accTestNumber, simplexSize);
+            int simplexDataSize = simplexData->GetSize();
+            MPI_Send(&simplexDataSize, 1, MPI_INT, 0, MPI_MY_DATASIZE_TAG, MPI_COMM_WORLD);
+            MPI_Send(simplexData->GetBuffer(), simplexDataSize, MPI_INT, 0, MPI_MY_DATA_TAG, MPI_COMM_WORLD);
+            delete simplexData;
+            MPIIncidenceGraphData<IncidenceGraph> *igData = new MPIIncidenceGraphData<IncidenceGraph>(ig);
+            int igDataSize = igData->GetSize();
+            MPI_Send(&igDataSize, 1, MPI_INT, 0, MPI_MY_DATASIZE_TAG, MPI_COMM_WORLD);
+            MPI_Send(igData->GetBuffer(), igDataSize, MPI_INT, 0, MPI_MY_DATA_TAG, MPI_COMM_WORLD);
+            delete igData;
+            delete ig;
+        }
+#ifdef ACCSUB_TRACE
+        std::cout<<"process "<<processRank<<" computed "<<ranges.size()<<" packs of local input"<<std::endl;
+#endif
+    }
+
+    // processRank can be MPI_ANY_SOURCE, it is set to rank of sender
+    static int *ReceiveData(int &processRank, int &dataSize)
+    {
+        MPI_Status status;
+        MPI_Recv(&dataSize, 1, MPI_INT, processRank, MPI_MY_DATASIZE_TAG, MPI_COMM_WORLD, &status);
+        processRank = status.MPI_SOURCE;
+        int *buffer = new int[dataSize];
+        MPI_Recv(buffer, dataSize, MPI_INT, processRank, MPI_MY_DATA_TAG, MPI_COMM_WORLD, &status);
+        return buffer;
+    }
+#endif
+
 public:
 
+    // slaves read packs from binary file themselves, master broadcasts
+    // only ranges of simplices and border vertices of all packs. pack i
+    // is computed by slave 1 + i % slavesCount. slaves send back reduced
+    // graphs with their simplices, which are stored in simplexList
+    static void ComputeLocalInput(const std::string &filename, Nodes &nodes, SimplexList &simplexList, AccSubAlgorithm accSubAlgorithm, AccTest *accTest)
+    {
+#ifdef USE_MPI
+        ComputationsParallelMPI::accSubAlgorithm = accSubAlgorithm;
+        ComputationsParallelMPI::accTest = accTest;
+        int tasksCount;
+        MPI_Comm_size(MPI_COMM_WORLD, &tasksCount);
+        if (tasksCount < 2)
+        {
+            throw std::string("ComputationsParallelMPI: local input needs at least one slave");
+        }
+        int slavesCount = tasksCount - 1;
+        std::vector<std::pair<int, int> > ranges;
+        std::vector<const std::set<Vertex> *> borders;
+        for (int i = 0; i < (int)nodes.size(); i++)
+        {
+            nodes[i]->processRank = 1 + i % slavesCount;
+            ranges.push_back(nodes[i]->simplexRange);
+            borders.push_back(&nodes[i]->borderVerts);
+        }
+        MPILocalInputData<IncidenceGraph> *data = new MPILocalInputData<IncidenceGraph>(filename, ranges, borders, accSubAlgorithm, accTest->GetID());
+        int dataSize = data->GetSize();
+        for (int rank = 1; rank < tasksCount; rank++)
+        {
+            MPI_Send(&dataSize, 1, MPI_INT, rank, MPI_MY_LOCAL_INPUT_TAG, MPI_COMM_WORLD);
+        }
+        MPI_Bcast(data->GetBuffer(), dataSize, MPI_INT, 0, MPI_COMM_WORLD);
+        delete data;
+#ifdef ACCSUB_TRACE
+        Timer::Update("broadcasting packs");
+#endif
+
+        // every slave sends its packs in order, results are unpacked when
+        // all simplices are received, so they are not moved in simplexList
+        std::vector<Nodes> slavesNodes(tasksCount);
+        for (typename Nodes::iterator node = nodes.begin(); node != nodes.end(); node++)
+        {
+            slavesNodes[(*node)->processRank].push_back(*node);
+        }
+        std::vector<int> slavesReceived(tasksCount, 0);
+        std::vector<MPISimplexData<IncidenceGraph> *> simplexData(nodes.size());
+        std::vector<std::pair<int *, int> > igData(nodes.size());
+        std::vector<Node *> receivedNodes(nodes.size());
+        int simplicesCount = simplexList.size();
+        for (int i = 0; i < (int)nodes.size(); i++)
+        {
+            int rank = MPI_ANY_SOURCE;
+            int simplexDataSize;
+            int *buffer = ReceiveData(rank, simplexDataSize);
+            simplexData[i] = new MPISimplexData<IncidenceGraph>(buffer, simplexDataSize);
+            // number of simplices follows their size
+            simplicesCount += buffer[1];
+            igData[i].first = ReceiveData(rank, igData[i].second);
+            receivedNodes[i] = slavesNodes[rank][slavesReceived[rank]++];
+        }
+        simplexList.reserve(simplicesCount);
+        for (int i = 0; i < (int)nodes.size(); i++)
+        {
+            int first = simplexList.size();
+            std::set<Vertex> borderVerts;
+            int alg;
+            int accTestNumber;
+            simplexData[i]->GetSimplexData(simplexList, borderVerts, alg, accTestNumber);
+            delete simplexData[i];
+            Node *node = receivedNodes[i];
+            for (int s = first; s < (int)simplexList.size(); s++)
+            {
+                node->simplexPtrList.push_back(&simplexList[s]);
+            }
+            SetMPIIncidenceGraphData(node, igData[i].first, igData[i].second);
+        }
+        std::cout<<"parallel computing done"<<std::endl;
+#endif
+    }
+
     static void Compute(Nodes &nodes, AccSubAlgorithm accSubAlgorithm, AccTest *accTest)
     {
 #ifdef ACCSUB_TRACE
@@ -102,59 +983,113 @@ public:
 #ifdef USE_MPI
         ComputationsParallelMPI::accSubAlgorithm = accSubAlgorithm;
         ComputationsParallelMPI::accTest = accTest;
-        int nodesCount = nodes.size();
-        int currentNode = 0;
-        int tasksCount;
-        int dataSize;
-        MPI_Status status;
-        std::map<int, Node *> rankToNode;
+        ComputeTasks(nodes, false);
+        std::cout<<"parallel computing done"<<std::endl;
+#endif
+    }
 
+    // slaves keep computed packs and join acyclic subsets themselves.
+    // master broadcasts only ranks of packs and pairs of neighbouring
+    // packs. slaves exchange borders of components with processes
+    // keeping neighbouring packs, spanning tree is built in Boruvka
+    // rounds reduced over all processes and faces added on border
+    // of a pack are sent directly to processes keeping packs sharing
+    // them, so the result is the same as if graphs were joined by
+    // master. then reduced graphs and isolated components are gathered
+    static void ComputeDistributed(Nodes &nodes, Nodes &isolatedNodes, AccSubAlgorithm accSubAlgorithm, AccTest *accTest)
+    {
+#ifdef USE_MPI
+        ComputationsParallelMPI::accSubAlgorithm = accSubAlgorithm;
+        ComputationsParallelMPI::accTest = accTest;
+        int tasksCount;
         MPI_Comm_size(MPI_COMM_WORLD, &tasksCount);
-
-        int size = (tasksCount < (nodesCount + 1)) ? tasksCount : (nodesCount + 1);
-
-        // as long as we have free nodes we send data to them
-        for (int rank = 1; rank < size; rank++)
+        if (tasksCount < 2)
         {
-            std::cout<<"sending node "<<currentNode<<" to process: "<<rank<<std::endl;
-            rankToNode[rank] = nodes[currentNode];
-            SendMPISimplexData(nodes[currentNode++], rank);
+            throw std::string("ComputationsParallelMPI: distributed join needs at least one slave");
         }
+        ComputeTasks(nodes, true);
+#ifdef ACCSUB_TRACE
+        Timer::Update("computing kept packs");
+#endif
 
-        // then we find for a node to finish
-        while (currentNode < nodesCount)
+        std::map<Node *, int> packsIndices;
+        for (int i = 0; i < (int)nodes.size(); i++)
         {
-            // getting size of the data
-            MPI_Recv(&dataSize, 1, MPI_INT, MPI_ANY_SOURCE, MPI_MY_DATASIZE_TAG, MPI_COMM_WORLD, &status);
-            int *buffer = new int[dataSize];
-
-            // getting data
-            MPI_Recv(buffer, dataSize, MPI_INT, status.MPI_SOURCE, MPI_MY_DATA_TAG, MPI_COMM_WORLD, &status);
-#ifdef DEBUG_MPI
-            std::cout<<"process 0 ";
-            Timer::TimeStamp("received data");
-#endif
-            SetMPIIncidenceGraphData(rankToNode[status.MPI_SOURCE], buffer, size);
-            std::cout<<"sending node "<<currentNode<<" to process: "<<status.MPI_SOURCE<<std::endl;
-            rankToNode[status.MPI_SOURCE] = nodes[currentNode];
-            SendMPISimplexData(nodes[currentNode++], status.MPI_SOURCE);
+            packsIndices[nodes[i]] = i;
         }
-
-        // finally we wait for all nodes that sill compute
-        for (int rank = 1; rank < size; ++rank)
+        std::vector<int> packsInfo(1, nodes.size());
+        for (typename Nodes::iterator node = nodes.begin(); node != nodes.end(); node++)
         {
-            // getting size of the data
-            MPI_Recv(&dataSize, 1, MPI_INT, MPI_ANY_SOURCE, MPI_MY_DATASIZE_TAG, MPI_COMM_WORLD, &status);
-            int *buffer = new int[dataSize];
-            // getting data
-            MPI_Recv(buffer, dataSize, MPI_INT, status.MPI_SOURCE, MPI_MY_DATA_TAG, MPI_COMM_WORLD, &status);
-#ifdef DEBUG_MPI
-            std::cout<<"process 0 ";
-            Timer::TimeStamp("received data");
+            packsInfo.push_back((*node)->processRank);
+        }
+        std::vector<int> packsEdges;
+        for (int i = 0; i < (int)nodes.size(); i++)
+        {
+            for (typename PartitionGraph::Edges::iterator edge = nodes[i]->edges.begin(); edge != nodes[i]->edges.end(); edge++)
+            {
+                int j = packsIndices[((*edge)->nodeA == nodes[i]) ? (*edge)->nodeB : (*edge)->nodeA];
+                if (i < j)
+                {
+                    packsEdges.push_back(i);
+                    packsEdges.push_back(j);
+                }
+            }
+        }
+        packsInfo.push_back(packsEdges.size() / 2);
+        packsInfo.insert(packsInfo.end(), packsEdges.begin(), packsEdges.end());
+        int packsInfoSize = packsInfo.size();
+        for (int rank = 1; rank < tasksCount; rank++)
+        {
+            MPI_Send(&packsInfoSize, 1, MPI_INT, rank, MPI_MY_JOIN_TAG, MPI_COMM_WORLD);
+        }
+        MPI_Bcast(&packsInfo[0], packsInfoSize, MPI_INT, 0, MPI_COMM_WORLD);
+        KeptPacks noPacks;
+        JoinKeptPacks(noPacks, packsInfo, 0);
+#ifdef ACCSUB_TRACE
+        Timer::Update("joining acyclic subsets");
 #endif
-            SetMPIIncidenceGraphData(rankToNode[status.MPI_SOURCE], buffer, size);
+
+        // slaves send isolated components and reduced graphs in order
+        // of their packs
+        std::vector<Nodes> slavesNodes(tasksCount);
+        for (typename Nodes::iterator node = nodes.begin(); node != nodes.end(); node++)
+        {
+            slavesNodes[(*node)->processRank].push_back(*node);
         }
-        std::cout<<"parallel computing done"<<std::endl;
+        std::map<int, SimplexPtrList> simplexPtrLists;
+        for (int rank = 1; rank < tasksCount; rank++)
+        {
+            for (typename Nodes::iterator node = slavesNodes[rank].begin(); node != slavesNodes[rank].end(); node++)
+            {
+                int dataSize;
+                int *buffer = ReceiveData(rank, dataSize);
+                int index = 0;
+                int isolatedCount = buffer[index++];
+                for (int i = 0; i < isolatedCount; i++)
+                {
+                    SimplexPtrList &simplexPtrList = simplexPtrLists[buffer[index++]];
+                    int count = buffer[index++];
+                    for (int j = 0; j < count; j++)
+                    {
+                        simplexPtrList.push_back((*node)->simplexPtrList[buffer[index++]]);
+                    }
+                }
+                assert(index == dataSize);
+                delete [] buffer;
+                buffer = ReceiveData(rank, dataSize);
+                SetMPIIncidenceGraphData(*node, buffer, dataSize);
+            }
+        }
+        for (typename std::map<int, SimplexPtrList>::iterator i = simplexPtrLists.begin(); i != simplexPtrLists.end(); i++)
+        {
+            isolatedNodes.push_back(new Node(i->second));
+        }
+#ifdef ACCSUB_TRACE
+        Timer::Update("gathering reduced graphs");
+#endif
+
+        ComputeTasks(isolatedNodes, false);
+        std::cout<<"distributed computing done"<<std::endl;
 #endif
     }
 
@@ -162,33 +1097,83 @@ public:
     {
 #ifdef USE_MPI
         MPI_Status status;
+        MPI_Status sizeStatus;
+        MPI_Request sizeRequest;
+        MPI_Request dataRequest = MPI_REQUEST_NULL;
+        int sizeReceived = 0;
         int dataSize;
+        int *buffer = 0;
+        double idleTime = 0;
+        KeptPacks keptPacks;
 
+        MPI_Irecv(&dataSize, 1, MPI_INT, 0, MPI_ANY_TAG, MPI_COMM_WORLD, &sizeRequest);
         while (1)
         {
-            // first message
-            MPI_Recv(&dataSize, 1, MPI_INT, 0, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+            double idleStart = MPI_Wtime();
+
+            // first message (unless already received)
+            if (!sizeReceived)
+            {
+                MPI_Wait(&sizeRequest, &sizeStatus);
+                sizeReceived = 1;
+            }
 
             // if it is die command
-            if (status.MPI_TAG == MPI_MY_DIE_TAG)
+            if (sizeStatus.MPI_TAG == MPI_MY_DIE_TAG)
             {
+#ifdef ACCSUB_TRACE
+                std::cout<<"process "<<processRank<<" idle time: "<<idleTime<<"s"<<std::endl;
+#endif
+                for (typename KeptPacks::iterator pack = keptPacks.begin(); pack != keptPacks.end(); pack++)
+                {
+                    delete (*pack);
+                }
                 return;
             }
 
-            if (status.MPI_TAG == MPI_MY_MEMORY_INFO_TAG)
+            if (sizeStatus.MPI_TAG == MPI_MY_MEMORY_INFO_TAG)
             {
                 std::cout<<"process "<<processRank<<" ";
                 MemoryInfo::Print();
                 int memory = MemoryInfo::GetMaxUsage();
                 MPI_Send(&memory, 1, MPI_INT, 0, MPI_MY_MEMORY_INFO_TAG, MPI_COMM_WORLD);
+                MPI_Irecv(&dataSize, 1, MPI_INT, 0, MPI_ANY_TAG, MPI_COMM_WORLD, &sizeRequest);
+                sizeReceived = 0;
+                continue;
+            }
+
+            if (sizeStatus.MPI_TAG == MPI_MY_LOCAL_INPUT_TAG)
+            {
+                ComputeLocalInputPacks(processRank, dataSize);
+                MPI_Irecv(&dataSize, 1, MPI_INT, 0, MPI_ANY_TAG, MPI_COMM_WORLD, &sizeRequest);
+                sizeReceived = 0;
                 continue;
             }
 
-            assert(status.MPI_TAG == MPI_MY_DATASIZE_TAG);
+            // all processes join acyclic subsets of kept packs together,
+            // then reduced graphs are sent to master
+            if (sizeStatus.MPI_TAG == MPI_MY_JOIN_TAG)
+            {
+                std::vector<int> packsInfo(dataSize);
+                MPI_Bcast(&packsInfo[0], dataSize, MPI_INT, 0, MPI_COMM_WORLD);
+                JoinKeptPacks(keptPacks, packsInfo, processRank);
+                SendKeptPacks(keptPacks);
+                MPI_Irecv(&dataSize, 1, MPI_INT, 0, MPI_ANY_TAG, MPI_COMM_WORLD, &sizeRequest);
+                sizeReceived = 0;
+                continue;
+            }
 
-            // getting data to compute
-            int *buffer = new int[dataSize];
-            MPI_Recv(buffer, dataSize, MPI_INT, 0, MPI_MY_WORK_TAG, MPI_COMM_WORLD, &status);
+            assert(sizeStatus.MPI_TAG == MPI_MY_DATASIZE_TAG || sizeStatus.MPI_TAG == MPI_MY_KEEP_DATASIZE_TAG);
+            bool keep = (sizeStatus.MPI_TAG == MPI_MY_KEEP_DATASIZE_TAG);
+
+            // getting data to compute (unless already requested)
+            if (dataRequest == MPI_REQUEST_NULL)
+            {
+                buffer = new int[dataSize];
+                MPI_Irecv(buffer, dataSize, MPI_INT, 0, MPI_MY_WORK_TAG, MPI_COMM_WORLD, &dataRequest);
+            }
+            MPI_Wait(&dataRequest, &status);
+            idleTime += (MPI_Wtime() - idleStart);
 #ifdef DEBUG_MPI
             std::cout<<"process "<<processRank<<" ";
             Timer::TimeStamp("received data");
@@ -196,48 +1181,60 @@ public:
 
             // formatting buffer into input data
             MPISimplexData<IncidenceGraph> *data = new MPISimplexData<IncidenceGraph>(buffer, dataSize);
-            SimplexList simplexList;
+
+            // next task is received while current one is computed
+            MPI_Irecv(&dataSize, 1, MPI_INT, 0, MPI_ANY_TAG, MPI_COMM_WORLD, &sizeRequest);
+            MPI_Test(&sizeRequest, &sizeReceived, &sizeStatus);
+            if (sizeReceived && (sizeStatus.MPI_TAG == MPI_MY_DATASIZE_TAG || sizeStatus.MPI_TAG == MPI_MY_KEEP_DATASIZE_TAG))
+            {
+                buffer = new int[dataSize];
+                MPI_Irecv(buffer, dataSize, MPI_INT, 0, MPI_MY_WORK_TAG, MPI_COMM_WORLD, &dataRequest);
+            }
+
+            // kept pack owns simplices used by its graph
+            KeptPack *keptPack = keep ? new KeptPack() : 0;
+            SimplexList localSimplexList;
+            SimplexList &simplexList = keep ? keptPack->simplexList : localSimplexList;
             std::set<Vertex> borderVerts;
             int accSubAlgorithm;
             int accTestNumber;
             data->GetSimplexData(simplexList, borderVerts, accSubAlgorithm, accTestNumber);
+            // received buffer is not needed any more
+            delete data;
 #ifdef DEBUG_MPI
             std::cout<<"process "<<processRank<<" ";
             Timer::TimeStamp("upacked data");
 #endif
-            AccTest *accTest = AccTest::Create(accTestNumber, Simplex::GetSimplexListDimension(simplexList));
 
             // main computations
-            IncidenceGraph *ig = 0;
-            if (accSubAlgorithm == AccSubAlgorithm::AccSubIG)
-            {
-                ig = IncidenceGraphHelpers<IncidenceGraph>::CreateAndCalculateAccSubIGWithBorder(simplexList, borderVerts, accTest);
-            }
-            else
+            IncidenceGraph *ig = CreateIncidenceGraph(simplexList, borderVerts, accSubAlgorithm, accTestNumber);
+
+            if (keep)
             {
-                ig = IncidenceGraphHelpers<IncidenceGraph>::CreateAndCalculateAccSubSTWithBorder(simplexList, borderVerts, accTest);
+                KeepPack(keptPacks, keptPack, ig);
+                int componentsCount = ig->connectedComponents.size();
+                int resultSize = 1;
+                MPI_Send(&resultSize, 1, MPI_INT, 0, MPI_MY_DATASIZE_TAG, MPI_COMM_WORLD);
+                MPI_Send(&componentsCount, 1, MPI_INT, 0, MPI_MY_DATA_TAG, MPI_COMM_WORLD);
+                continue;
             }
-            ig->UpdateConnectedComponents();
             ig->AssignNewIndices(true);
 
-            delete data;
-            delete accTest;
-
             // writting results into buffer
             MPIIncidenceGraphData<IncidenceGraph> *igData = new MPIIncidenceGraphData<IncidenceGraph>(ig);
 #ifdef DEBUG_MPI
             std::cout<<"process "<<processRank<<" ";
             Timer::TimeStamp("packing data");
 #endif
-            dataSize = igData->GetSize();
+            int igDataSize = igData->GetSize();
 
 #ifdef DEBUG_MPI
             std::cout<<"process "<<processRank<<" ";
             Timer::TimeStamp("sending data");
 #endif
             // sending to master node
-            MPI_Send(&dataSize, 1, MPI_INT, 0, MPI_MY_DATASIZE_TAG, MPI_COMM_WORLD);
-            MPI_Send(igData->GetBuffer(), dataSize, MPI_INT,0, MPI_MY_DATA_TAG, MPI_COMM_WORLD);
+            MPI_Send(&igDataSize, 1, MPI_INT, 0, MPI_MY_DATASIZE_TAG, MPI_COMM_WORLD);
+            MPI_Send(igData->GetBuffer(), igDataSize, MPI_INT, 0, MPI_MY_DATA_TAG, MPI_COMM_WORLD);
 
             delete igData;
             delete ig;
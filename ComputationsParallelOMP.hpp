@@ -13,6 +13,12 @@
 #define	COMPUTATIONSPARALLELOMP_HPP
 
 #include "ComputationsLocal.hpp"
+#include <algorithm> // sort
+#include <ctime>
+
+#ifdef USE_OMP
+#include <omp.h>
+#endif
 
 #ifdef ACCSUB_TRACE
 #include "Utils.hpp"
@@ -25,8 +31,22 @@ class ComputationsParallelOMP
     typedef typename PartitionGraph::AccTest AccTest;
     typedef typename PartitionGraph::AccSubAlgorithm AccSubAlgorithm;
 
+    // (estimated cost, pack index)
+    typedef std::pair<float, int> PackCost;
+
+    struct LargestFirst
+    {
+        bool operator()(const PackCost &a, const PackCost &b) const
+        {
+            return (a.first > b.first || (a.first == b.first && a.second < b.second));
+        }
+    };
+
 public:
 
+    // packs are sorted by estimated cost and spawned as tasks largest
+    // first, idle threads take next tasks from the pool, so expensive
+    // packs do not end up at the end of static chunks
     static void Compute(Nodes &nodes, AccSubAlgorithm accSubAlgorithm, AccTest *accTest)
     {
 #ifdef ACCSUB_TRACE
@@ -41,19 +61,91 @@ public:
             std::cout<<"using AccSubST"<<std::endl;
         }
 #endif
-        #pragma omp parallel for
-        for (typename Nodes::iterator i = nodes.begin(); i != nodes.end(); i++)
+        int count = nodes.size();
+        std::vector<PackCost> order(count);
+        for (int i = 0; i < count; i++)
         {
-            ComputationsLocal<PartitionGraph>::CreateIncidenceGraph(*i, accSubAlgorithm, accTest);
+            order[i] = PackCost(nodes[i]->GetEstimatedCost(), i);
+        }
+        std::sort(order.begin(), order.end(), LargestFirst());
+
 #ifdef ACCSUB_TRACE
-            Timer::TimeStamp("incidence graph calculated");
+        std::vector<double> busyTimes(Threads::GetThreadsCount(), 0);
+        std::vector<int> packsCount(Threads::GetThreadsCount(), 0);
+        double wallStart = GetTime();
+#endif
+#ifdef USE_OMP
+        #pragma omp parallel
 #endif
+        {
+#ifdef USE_OMP
+            #pragma omp single nowait
+#endif
+            for (int i = 0; i < count; i++)
+            {
+#ifdef USE_OMP
+                #pragma omp task firstprivate(i)
+#endif
+                {
+#ifdef ACCSUB_TRACE
+                    double taskStart = GetTime();
+#endif
+                    ComputationsLocal<PartitionGraph>::CreateIncidenceGraph(nodes[order[i].second], accSubAlgorithm, accTest);
+#ifdef ACCSUB_TRACE
+                    int thread = Threads::GetThreadNumber();
+                    busyTimes[thread] += GetTime() - taskStart;
+                    packsCount[thread]++;
+#endif
+                }
+            }
         }
+
 #ifdef ACCSUB_TRACE
+        double wallTime = GetTime() - wallStart;
+        if (count > 0)
+        {
+            PrintReport(order, busyTimes, packsCount, wallTime);
+        }
         Timer::TimeStamp("ComputationsParallelOMP end");
         Timer::TimeFrom(start, "total distributed computations");
 #endif
     }
+
+#ifdef ACCSUB_TRACE
+
+    static void PrintReport(const std::vector<PackCost> &order, const std::vector<double> &busyTimes, const std::vector<int> &packsCount, double wallTime)
+    {
+        if (order.size() > 0)
+        {
+            std::cout<<"estimated pack cost: max "<<order.front().first<<" min "<<order.back().first<<std::endl;
+        }
+        std::cout<<"packs computations wall time: "<<wallTime<<"s"<<std::endl;
+        double total = 0;
+        double max = 0;
+        for (int i = 0; i < (int)busyTimes.size(); i++)
+        {
+            std::cout<<"thread "<<i<<" busy: "<<busyTimes[i]<<"s packs: "<<packsCount[i]<<std::endl;
+            total += busyTimes[i];
+            max = std::max(max, busyTimes[i]);
+        }
+        if (total > 0)
+        {
+            std::cout<<"load imbalance (max / avg): "<<(max * busyTimes.size() / total)<<std::endl;
+        }
+    }
+
+private:
+
+    static double GetTime()
+    {
+#ifdef USE_OMP
+        return omp_get_wtime();
+#else
+        return double(clock()) / CLOCKS_PER_SEC;
+#endif
+    }
+
+#endif
 };
 
 #endif	/* COMPUTATIONSPARALLELOMP_HPP */
@@ -0,0 +1,447 @@
+/*
+ * File:   ComputationsParallelSHM.hpp
+ * Author: Piotr Brendel
+ *         piotr.brendel@ii.uj.edu.pl
+ *
+ *         AccSub - constructing and removing acyclic subset
+ *                  for simplicial complexes
+ *         This code is a part of RedHom library
+ *         http://redhom.ii.uj.edu.pl
+ */
+
+#ifndef COMPUTATIONSPARALLELSHM_HPP
+#define	COMPUTATIONSPARALLELSHM_HPP
+
+#include "ComputationsLocal.hpp"
+#include "MPIData.hpp"
+#include <algorithm> // sort
+#include <vector>
+
+#ifdef USE_SHM
+#include <cstring>
+#include <cstdio>
+#include <pthread.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/time.h>
+#include <ctime>
+#endif
+
+#ifdef ACCSUB_TRACE
+#include "Utils.hpp"
+#endif
+
+////////////////////////////////////////////////////////////////////////////////
+
+// packs are computed by forked worker processes, every worker has its own
+// address space and allocator. packed tasks (MPISimplexData) are placed
+// in POSIX shared memory before workers are forked, workers take them in
+// order of estimated cost and write packed results (MPIIncidenceGraphData)
+// to shared ring read by master. without USE_SHM packs are computed
+// locally
+template <typename PartitionGraph>
+class ComputationsParallelSHM
+{
+    typedef typename PartitionGraph::IncidenceGraph IncidenceGraph;
+    typedef typename PartitionGraph::Vertex Vertex;
+    typedef typename PartitionGraph::Simplex Simplex;
+    typedef typename PartitionGraph::SimplexList SimplexList;
+    typedef typename PartitionGraph::Node Node;
+    typedef typename PartitionGraph::Nodes Nodes;
+    typedef typename PartitionGraph::AccTest AccTest;
+    typedef typename PartitionGraph::AccSubAlgorithm AccSubAlgorithm;
+
+    // (estimated cost, pack index)
+    typedef std::pair<float, int> PackCost;
+
+    struct LargestFirst
+    {
+        bool operator()(const PackCost &a, const PackCost &b) const
+        {
+            return (a.first > b.first || (a.first == b.first && a.second < b.second));
+        }
+    };
+
+    static int workersCount;
+    static int resultsRingSize;
+
+#ifdef USE_SHM
+    // beginning of shared memory segment, followed by tasks offsets
+    // (tasksCount + 1 longs), tasks data and results ring
+    struct SharedControl
+    {
+        pthread_mutex_t     mutex;
+        pthread_mutex_t     writerMutex;
+        pthread_cond_t      resultsNotEmpty;
+        pthread_cond_t      resultsNotFull;
+        int                 tasksCount;
+        int                 nextTask;
+        long                resultsCapacity;
+        long                resultsHead;
+        long                resultsTail;
+    };
+
+    struct SharedMemory
+    {
+        void                *address;
+        size_t              size;
+        SharedControl       *control;
+        long                *tasksOffsets;
+        int                 *tasks;
+        int                 *results;
+    };
+
+    static void CreateSharedMemory(SharedMemory &shm, const std::vector<MPISimplexData<IncidenceGraph> *> &tasksData)
+    {
+        int tasksCount = tasksData.size();
+        long tasksSize = 0;
+        for (int i = 0; i < tasksCount; i++)
+        {
+            tasksSize += tasksData[i]->GetSize();
+        }
+        shm.size = sizeof(SharedControl) + sizeof(long) * (tasksCount + 1) + sizeof(int) * (tasksSize + resultsRingSize);
+
+        char name[64];
+        static int segmentsCount = 0;
+        sprintf(name, "/accsub.%d.%d", (int)getpid(), segmentsCount++);
+        int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd == -1)
+        {
+            throw std::string("ComputationsParallelSHM: can't create shared memory ") + name;
+        }
+        // segment is removed when last process unmaps it
+        shm_unlink(name);
+        if (ftruncate(fd, shm.size) != 0)
+        {
+            close(fd);
+            throw std::string("ComputationsParallelSHM: can't resize shared memory ") + name;
+        }
+        shm.address = mmap(0, shm.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (shm.address == MAP_FAILED)
+        {
+            throw std::string("ComputationsParallelSHM: can't map shared memory ") + name;
+        }
+
+        shm.control = (SharedControl *)shm.address;
+        shm.tasksOffsets = (long *)(shm.control + 1);
+        shm.tasks = (int *)(shm.tasksOffsets + tasksCount + 1);
+        shm.results = shm.tasks + tasksSize;
+
+        pthread_mutexattr_t mutexAttr;
+        pthread_mutexattr_init(&mutexAttr);
+        pthread_mutexattr_setpshared(&mutexAttr, PTHREAD_PROCESS_SHARED);
+        pthread_mutex_init(&shm.control->mutex, &mutexAttr);
+        pthread_mutex_init(&shm.control->writerMutex, &mutexAttr);
+        pthread_mutexattr_destroy(&mutexAttr);
+        pthread_condattr_t condAttr;
+        pthread_condattr_init(&condAttr);
+        pthread_condattr_setpshared(&condAttr, PTHREAD_PROCESS_SHARED);
+        pthread_cond_init(&shm.control->resultsNotEmpty, &condAttr);
+        pthread_cond_init(&shm.control->resultsNotFull, &condAttr);
+        pthread_condattr_destroy(&condAttr);
+        shm.control->tasksCount = tasksCount;
+        shm.control->nextTask = 0;
+        shm.control->resultsCapacity = resultsRingSize;
+        shm.control->resultsHead = 0;
+        shm.control->resultsTail = 0;
+
+        shm.tasksOffsets[0] = 0;
+        for (int i = 0; i < tasksCount; i++)
+        {
+            int size = tasksData[i]->GetSize();
+            memcpy(shm.tasks + shm.tasksOffsets[i], tasksData[i]->GetBuffer(), sizeof(int) * size);
+            shm.tasksOffsets[i + 1] = shm.tasksOffsets[i] + size;
+        }
+    }
+
+    static void DestroySharedMemory(SharedMemory &shm)
+    {
+        pthread_cond_destroy(&shm.control->resultsNotEmpty);
+        pthread_cond_destroy(&shm.control->resultsNotFull);
+        pthread_mutex_destroy(&shm.control->writerMutex);
+        pthread_mutex_destroy(&shm.control->mutex);
+        munmap(shm.address, shm.size);
+    }
+
+    // whole message is written at once, so results of different workers
+    // are not interleaved. messages bigger than ring are streamed
+    static void WriteResults(SharedMemory &shm, const int *header, int headerSize, const int *data, int size)
+    {
+        SharedControl *control = shm.control;
+        pthread_mutex_lock(&control->writerMutex);
+        pthread_mutex_lock(&control->mutex);
+        const int *parts[2] = { header, data };
+        int sizes[2] = { headerSize, size };
+        for (int p = 0; p < 2; p++)
+        {
+            const int *src = parts[p];
+            long count = sizes[p];
+            while (count > 0)
+            {
+                while (control->resultsHead - control->resultsTail == control->resultsCapacity)
+                {
+                    pthread_cond_wait(&control->resultsNotFull, &control->mutex);
+                }
+                long position = control->resultsHead % control->resultsCapacity;
+                long n = std::min(count, control->resultsCapacity - (control->resultsHead - control->resultsTail));
+                n = std::min(n, control->resultsCapacity - position);
+                memcpy(shm.results + position, src, sizeof(int) * n);
+                control->resultsHead += n;
+                src += n;
+                count -= n;
+                pthread_cond_signal(&control->resultsNotEmpty);
+            }
+        }
+        pthread_mutex_unlock(&control->mutex);
+        pthread_mutex_unlock(&control->writerMutex);
+    }
+
+    // waiting is interrupted every second to check if workers are alive
+    static void ReadResults(SharedMemory &shm, int *data, long count, std::vector<pid_t> &workers)
+    {
+        SharedControl *control = shm.control;
+        pthread_mutex_lock(&control->mutex);
+        while (count > 0)
+        {
+            while (control->resultsHead == control->resultsTail)
+            {
+                struct timeval now;
+                gettimeofday(&now, 0);
+                struct timespec timeout;
+                timeout.tv_sec = now.tv_sec + 1;
+                timeout.tv_nsec = now.tv_usec * 1000;
+                if (pthread_cond_timedwait(&control->resultsNotEmpty, &control->mutex, &timeout) != 0 && control->resultsHead == control->resultsTail)
+                {
+                    pthread_mutex_unlock(&control->mutex);
+                    CheckWorkers(workers);
+                    pthread_mutex_lock(&control->mutex);
+                }
+            }
+            long position = control->resultsTail % control->resultsCapacity;
+            long n = std::min(count, control->resultsHead - control->resultsTail);
+            n = std::min(n, control->resultsCapacity - position);
+            memcpy(data, shm.results + position, sizeof(int) * n);
+            control->resultsTail += n;
+            data += n;
+            count -= n;
+            pthread_cond_signal(&control->resultsNotFull);
+        }
+        pthread_mutex_unlock(&control->mutex);
+    }
+
+    // workers finish when there are no more tasks, so any worker that
+    // stopped with an error means its results will never come
+    static void CheckWorkers(std::vector<pid_t> &workers)
+    {
+        for (typename std::vector<pid_t>::iterator pid = workers.begin(); pid != workers.end(); pid++)
+        {
+            int status;
+            if (*pid == 0 || waitpid(*pid, &status, WNOHANG) != *pid)
+            {
+                continue;
+            }
+            *pid = 0;
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            {
+                for (typename std::vector<pid_t>::iterator other = workers.begin(); other != workers.end(); other++)
+                {
+                    if (*other != 0)
+                    {
+                        kill(*other, SIGKILL);
+                        waitpid(*other, &status, 0);
+                        *other = 0;
+                    }
+                }
+                throw std::string("ComputationsParallelSHM: worker process failed");
+            }
+        }
+    }
+
+    static void Worker(SharedMemory &shm)
+    {
+        SharedControl *control = shm.control;
+        while (true)
+        {
+            pthread_mutex_lock(&control->mutex);
+            int task = control->nextTask++;
+            pthread_mutex_unlock(&control->mutex);
+            if (task >= control->tasksCount)
+            {
+                return;
+            }
+
+            // task is copied, so it is owned by worker's allocator
+            int dataSize = shm.tasksOffsets[task + 1] - shm.tasksOffsets[task];
+            int *buffer = new int[dataSize];
+            memcpy(buffer, shm.tasks + shm.tasksOffsets[task], sizeof(int) * dataSize);
+            MPISimplexData<IncidenceGraph> *data = new MPISimplexData<IncidenceGraph>(buffer, dataSize);
+            SimplexList simplexList;
+            std::set<Vertex> borderVerts;
+            int accSubAlgorithm;
+            int accTestNumber;
+            data->GetSimplexData(simplexList, borderVerts, accSubAlgorithm, accTestNumber);
+            delete data;
+            AccTest *accTest = AccTest::Create(accTestNumber, Simplex::GetSimplexListDimension(simplexList));
+
+            IncidenceGraph *ig = 0;
+            if (accSubAlgorithm == AccSubAlgorithm::AccSubIG)
+            {
+                ig = IncidenceGraphHelpers<IncidenceGraph>::CreateAndCalculateAccSubIGWithBorder(simplexList, borderVerts, accTest);
+            }
+            else
+            {
+                ig = IncidenceGraphHelpers<IncidenceGraph>::CreateAndCalculateAccSubSTWithBorder(simplexList, borderVerts, accTest);
+            }
+            ig->UpdateConnectedComponents();
+            ig->AssignNewIndices(true);
+            delete accTest;
+
+            MPIIncidenceGraphData<IncidenceGraph> *igData = new MPIIncidenceGraphData<IncidenceGraph>(ig);
+            int header[2] = { task, igData->GetSize() };
+            WriteResults(shm, header, 2, igData->GetBuffer(), igData->GetSize());
+            delete igData;
+            delete ig;
+        }
+    }
+#endif
+
+public:
+
+    // 0 - number of online processors
+    static void SetWorkersCount(int count)
+    {
+        workersCount = count;
+    }
+
+    static void Compute(Nodes &nodes, AccSubAlgorithm accSubAlgorithm, AccTest *accTest)
+    {
+#ifdef ACCSUB_TRACE
+        Timer::TimeStamp("ComputationsParallelSHM start");
+        Timer::Time start = Timer::Now();
+        if (accSubAlgorithm == AccSubAlgorithm::AccSubIG)
+        {
+            std::cout<<"using AccSubIG"<<std::endl;
+        }
+        else
+        {
+            std::cout<<"using AccSubST"<<std::endl;
+        }
+#endif
+#ifdef USE_SHM
+        int count = nodes.size();
+        if (count == 0)
+        {
+            return;
+        }
+        std::vector<PackCost> order(count);
+        for (int i = 0; i < count; i++)
+        {
+            order[i] = PackCost(nodes[i]->GetEstimatedCost(), i);
+        }
+        std::sort(order.begin(), order.end(), LargestFirst());
+
+        std::vector<MPISimplexData<IncidenceGraph> *> tasksData(count);
+        for (int i = 0; i < count; i++)
+        {
+            Node *node = nodes[order[i].second];
+            tasksData[i] = new MPISimplexData<IncidenceGraph>(node->simplexPtrList, node->borderVerts, accSubAlgorithm, accTest->GetID(), Simplex::GetSimplexListConstantSize(node->simplexPtrList));
+        }
+        SharedMemory shm;
+        CreateSharedMemory(shm, tasksData);
+        for (int i = 0; i < count; i++)
+        {
+            delete tasksData[i];
+        }
+#ifdef ACCSUB_TRACE
+        Timer::Update("packing data to shared memory");
+#endif
+
+        int workers = (workersCount > 0) ? workersCount : (int)sysconf(_SC_NPROCESSORS_ONLN);
+        workers = std::max(1, std::min(workers, count));
+        // buffered output would be written by every process
+        std::cout.flush();
+        std::vector<pid_t> pids;
+        for (int i = 0; i < workers; i++)
+        {
+            pid_t pid = fork();
+            if (pid == 0)
+            {
+                int status = 0;
+                try
+                {
+                    Worker(shm);
+                }
+                catch (std::string &s)
+                {
+                    std::cerr<<"worker "<<i<<": "<<s<<std::endl;
+                    status = 1;
+                }
+                _exit(status);
+            }
+            if (pid == -1)
+            {
+                // remaining tasks are taken by workers already started
+                if (pids.size() == 0)
+                {
+                    DestroySharedMemory(shm);
+                    throw std::string("ComputationsParallelSHM: can't create worker process");
+                }
+                break;
+            }
+            pids.push_back(pid);
+        }
+
+        try
+        {
+            for (int i = 0; i < count; i++)
+            {
+                int header[2];
+                ReadResults(shm, header, 2, pids);
+                int *buffer = new int[header[1]];
+                ReadResults(shm, buffer, header[1], pids);
+                MPIIncidenceGraphData<IncidenceGraph> *igData = new MPIIncidenceGraphData<IncidenceGraph>(buffer, header[1]);
+                Node *node = nodes[order[header[0]].second];
+                node->ig = igData->GetIncidenceGraph(node->simplexPtrList);
+                delete igData;
+            }
+        }
+        catch (std::string &)
+        {
+            DestroySharedMemory(shm);
+            throw;
+        }
+        for (typename std::vector<pid_t>::iterator pid = pids.begin(); pid != pids.end(); pid++)
+        {
+            int status;
+            if (*pid != 0)
+            {
+                waitpid(*pid, &status, 0);
+            }
+        }
+        DestroySharedMemory(shm);
+#ifdef ACCSUB_TRACE
+        std::cout<<"worker processes: "<<pids.size()<<std::endl;
+#endif
+#else
+        for (typename Nodes::iterator i = nodes.begin(); i != nodes.end(); i++)
+        {
+            ComputationsLocal<PartitionGraph>::CreateIncidenceGraph(*i, accSubAlgorithm, accTest);
+        }
+#endif
+#ifdef ACCSUB_TRACE
+        Timer::TimeStamp("ComputationsParallelSHM end");
+        Timer::TimeFrom(start, "total distributed computations");
+#endif
+    }
+};
+
+template <typename PartitionGraph>
+int ComputationsParallelSHM<PartitionGraph>::workersCount = 0;
+template <typename PartitionGraph>
+int ComputationsParallelSHM<PartitionGraph>::resultsRingSize = 1 << 22;
+
+#endif	/* COMPUTATIONSPARALLELSHM_HPP */
@@ -15,19 +15,22 @@
 #include <vector>
 #include <map>
 
+#include "IntersectionFlagsHelpers.hpp"
+
 template <typename SimplexType, typename FlagsType>
 class ConfigurationsFlags
 {
     std::map<SimplexType, FlagsType> flags;
+    FlagsType emptyFlags;
 
 public:
 
-    ConfigurationsFlags()
+    ConfigurationsFlags() : emptyFlags(0)
     {
         // do nothing
     }
 
-    ConfigurationsFlags(int dim, bool subconfigurations, bool addMaximalSimplex)
+    ConfigurationsFlags(int dim, bool subconfigurations, bool addMaximalSimplex) : emptyFlags(0)
     {
         Create(dim, subconfigurations, addMaximalSimplex);
     }
@@ -74,9 +77,12 @@ public:
         }
     }
 
-    const FlagsType &operator[] (const SimplexType &s)
+    // const lookup (doesn't insert missing simplices), so the same
+    // flags can be read by many threads
+    const FlagsType &operator[] (const SimplexType &s) const
     {
-        return flags[s];
+        typename std::map<SimplexType, FlagsType>::const_iterator i = flags.find(s);
+        return (i != flags.end()) ? i->second : emptyFlags;
     }
 
     bool GetSimplex(const FlagsType &f, SimplexType &simplex)
@@ -122,5 +128,107 @@ std::ostream &operator<<(std::ostream &str, const ConfigurationsFlags<SimplexTyp
     return str;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+// faces in ConfigurationsFlags are generated in order of increasing dimension
+// so flags of all faces of given dimension form a contiguous block of bits.
+// for every dimension we keep a mask of this block, hence number of faces
+// of given dimension (and Euler characteristic) is just a popcount.
+template <typename FlagsType>
+class ConfigurationsDimensionsMasks
+{
+    std::vector<FlagsType> masks;
+
+    static int NewtonCoefficient(int n, int k)
+    {
+        if (k > n / 2)
+        {
+            k = n - k;
+        }
+        int numerator = 1;
+        int denominator = 1;
+        for (int i = 1; i <= k; i++)
+        {
+            numerator *= (n - i + 1);
+            denominator *= i;
+        }
+        return numerator / denominator;
+    }
+
+public:
+
+    ConfigurationsDimensionsMasks()
+    {
+        // do nothing
+    }
+
+    ConfigurationsDimensionsMasks(int dim)
+    {
+        Create(dim);
+    }
+
+    // masks[d] contains flags of all d-dimensional faces of the "base"
+    // simplex of dimension dim (including maximal simplex for d == dim)
+    void Create(int dim)
+    {
+        masks.clear();
+        FlagsType flag = 1;
+        for (int d = 0; d <= dim; d++)
+        {
+            FlagsType mask = 0;
+            int facesCount = NewtonCoefficient(dim + 1, d + 1);
+            for (int i = 0; i < facesCount; i++)
+            {
+                mask |= flag;
+                flag = flag << 1;
+            }
+            masks.push_back(mask);
+        }
+    }
+
+    const FlagsType &operator[](int d) const
+    {
+        return masks[d];
+    }
+
+    int size() const
+    {
+        return masks.size();
+    }
+
+    int GetFacesCount(const FlagsType &flags, int d) const
+    {
+        return IntersectionFlagsHelpers<FlagsType>::PopCount(flags & masks[d]);
+    }
+
+    // fills facesCount[0..size()-1] and returns highest dimension
+    // with nonzero number of faces (or -1 if there are no faces)
+    int GetFacesCount(const FlagsType &flags, int *facesCount) const
+    {
+        int lastNonzeroDim = -1;
+        for (int d = 0; d < (int)masks.size(); d++)
+        {
+            facesCount[d] = GetFacesCount(flags, d);
+            if (facesCount[d] != 0)
+            {
+                lastNonzeroDim = d;
+            }
+        }
+        return lastNonzeroDim;
+    }
+
+    // flags have to be closed under taking faces (subconfiguration flags)
+    int GetEulerCharacteristic(const FlagsType &flags) const
+    {
+        int eulerCharacteristic = 0;
+        for (int d = 0; d < (int)masks.size(); d++)
+        {
+            int count = GetFacesCount(flags, d);
+            eulerCharacteristic += (d % 2) ? -count : count;
+        }
+        return eulerCharacteristic;
+    }
+};
+
 #endif	/* CONFIGURATIONSFLAGS_HPP */
 
@@ -0,0 +1,202 @@
+/*
+ * File:   HomologyZ2.hpp
+ * Author: Piotr Brendel
+ *         piotr.brendel@ii.uj.edu.pl
+ *
+ *         AccSub - constructing and removing acyclic subset
+ *                  for simplicial complexes
+ *         This code is a part of RedHom library
+ *         http://redhom.ii.uj.edu.pl
+ */
+
+#ifndef HOMOLOGYZ2_HPP
+#define	HOMOLOGYZ2_HPP
+
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <cassert>
+
+enum HomologyZ2Mode
+{
+    HZ2_Clearing,
+    HZ2_Compression,
+    HZ2_Parallel
+};
+
+// Betti numbers with Z2 coefficients of output graph computed without
+// RedHom. boundaries of cells of every dimension are stored as sparse
+// matrices (CSR): rows of a column are positions of its faces among cells
+// of dimension less by one, sorted ascending. columns are reduced by
+// adding columns with the same lowest row, rank of boundary is a number
+// of nonzero reduced columns. modes:
+// - clearing: dimensions are reduced from the top, cells which are lowest
+//   rows of reduced columns are boundaries, so their own columns reduce
+//   to zero and are skipped
+// - compression: dimensions are reduced from the bottom, cells with
+//   nonzero reduced columns can not be lowest rows in dimension above, so
+//   their rows are removed before reduction
+// - parallel: every dimension is reduced separately (in parallel in
+//   OpenMP builds)
+// for complexes without torsion results are equal to integer Betti numbers.
+// cells can be added component by component as a sink of OutputGraph::Stream
+template <typename OutputGraph>
+class HomologyZ2T : public OutputGraph::Sink
+{
+    typedef typename OutputGraph::Nodes Nodes;
+    typedef std::vector<char> Marks;
+
+    struct Matrix
+    {
+        std::vector<int> offsets;
+        std::vector<int> rows;
+    };
+
+    // boundaries[d] - boundary of cells of dimension d
+    std::vector<Matrix> boundaries;
+    std::vector<int>    cellsCount;
+
+public:
+
+    typedef std::vector<int> Betti;
+
+    HomologyZ2T() { }
+
+    HomologyZ2T(OutputGraph *og)
+    {
+        AddNodes(og->nodes);
+    }
+
+    // indices of nodes have to be consecutive, faces have to be given
+    // in the same call
+    void AddNodes(const Nodes &nodes)
+    {
+        if (nodes.empty())
+        {
+            return;
+        }
+        int first = nodes.front()->index;
+        // positions of cells among cells of the same dimension
+        std::vector<int> positions(nodes.size());
+        for (int i = 0; i < (int)nodes.size(); i++)
+        {
+            assert(nodes[i]->index == first + i);
+            int dim = nodes[i]->simplex.size() - 1;
+            while (dim >= (int)cellsCount.size())
+            {
+                cellsCount.push_back(0);
+                boundaries.push_back(Matrix());
+                boundaries.back().offsets.push_back(0);
+            }
+            positions[i] = cellsCount[dim]++;
+        }
+        for (typename Nodes::const_iterator i = nodes.begin(); i != nodes.end(); i++)
+        {
+            Matrix &matrix = boundaries[(*i)->simplex.size() - 1];
+            int begin = matrix.rows.size();
+            for (typename Nodes::const_iterator j = (*i)->subnodes.begin(); j != (*i)->subnodes.end(); j++)
+            {
+                matrix.rows.push_back(positions[(*j)->index - first]);
+            }
+            std::sort(matrix.rows.begin() + begin, matrix.rows.end());
+            matrix.offsets.push_back(matrix.rows.size());
+        }
+    }
+
+    void ComputeBettiNumbers(Betti &betti, HomologyZ2Mode mode)
+    {
+        int dims = cellsCount.size();
+        // ranks[d] - rank of boundary of cells of dimension d
+        std::vector<int> ranks(dims + 1, 0);
+        if (mode == HZ2_Clearing)
+        {
+            Marks skipped;
+            for (int d = dims - 1; d > 0; d--)
+            {
+                Marks pivots(cellsCount[d - 1], 0);
+                ranks[d] = Reduce(boundaries[d], cellsCount[d - 1], skipped, Marks(), &pivots, 0);
+                skipped.swap(pivots);
+            }
+        }
+        else if (mode == HZ2_Compression)
+        {
+            Marks removed;
+            for (int d = 1; d < dims; d++)
+            {
+                Marks negative(cellsCount[d], 0);
+                ranks[d] = Reduce(boundaries[d], cellsCount[d - 1], Marks(), removed, 0, &negative);
+                removed.swap(negative);
+            }
+        }
+        else // (mode == HZ2_Parallel)
+        {
+#ifdef USE_OMP
+            #pragma omp parallel for schedule(dynamic)
+#endif
+            for (int d = 1; d < dims; d++)
+            {
+                ranks[d] = Reduce(boundaries[d], cellsCount[d - 1], Marks(), Marks(), 0, 0);
+            }
+        }
+        betti.resize(dims);
+        for (int d = 0; d < dims; d++)
+        {
+            betti[d] = cellsCount[d] - ranks[d] - ranks[d + 1];
+        }
+    }
+
+private:
+
+    // empty skipped or removed marks nothing. lowest rows of reduced
+    // columns are marked in pivots and nonzero columns in negative
+    static int Reduce(const Matrix &matrix, int rowsCount, const Marks &skipped, const Marks &removed, Marks *pivots, Marks *negative)
+    {
+        int columnsCount = matrix.offsets.size() - 1;
+        // only columns with lowest rows are kept
+        std::vector<std::vector<int> > reduced(columnsCount);
+        std::vector<int> lowestColumn(rowsCount, -1);
+        std::vector<int> column;
+        std::vector<int> sum;
+        int rank = 0;
+        for (int j = 0; j < columnsCount; j++)
+        {
+            if (!skipped.empty() && skipped[j])
+            {
+                continue;
+            }
+            column.clear();
+            for (int r = matrix.offsets[j]; r < matrix.offsets[j + 1]; r++)
+            {
+                if (removed.empty() || !removed[matrix.rows[r]])
+                {
+                    column.push_back(matrix.rows[r]);
+                }
+            }
+            while (!column.empty() && lowestColumn[column.back()] >= 0)
+            {
+                const std::vector<int> &other = reduced[lowestColumn[column.back()]];
+                sum.clear();
+                std::set_symmetric_difference(column.begin(), column.end(), other.begin(), other.end(), std::back_inserter(sum));
+                column.swap(sum);
+            }
+            if (column.empty())
+            {
+                continue;
+            }
+            lowestColumn[column.back()] = j;
+            if (pivots != 0)
+            {
+                (*pivots)[column.back()] = 1;
+            }
+            if (negative != 0)
+            {
+                (*negative)[j] = 1;
+            }
+            reduced[j].swap(column);
+            rank++;
+        }
+        return rank;
+    }
+};
+
+#endif	/* HOMOLOGYZ2_HPP */
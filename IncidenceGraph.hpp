@@ -16,7 +16,7 @@
 #include "ConfigurationsFlags.hpp"
 #include "AccTest.hpp"
 
-#include <cstring> // memset
+#include <functional> // greater
 #include <list>
 #include <queue>
 #include <set>
@@ -47,7 +47,7 @@ public:
     typedef std::vector<Node *> Nodes;
     typedef std::vector<Edge *> Edges;
     //typedef std::list<Edge *> Edges;
-    typedef std::list<Node *> Path;
+    typedef std::vector<Node *> Path;
     typedef Node *ConnectedComponent;
     typedef std::vector<ConnectedComponent> ConnectedComponents;
     typedef std::map<Vertex, Nodes> VertexHash;
@@ -134,6 +134,7 @@ public:
         }
 
         void SetParentGraph(IncidenceGraphT *g) { graph = g; }
+        IncidenceGraphT *GetParentGraph() { return graph; }
         PropertiesFlags GetPropertiesFlags() { return propertiesFlags; }
         AccInfo &GetAccInfo() { return accInfo; }
 
@@ -185,7 +186,7 @@ public:
             return (node == nodeA || node == nodeB);
         }
 
-        Simplex &GetIntersection()
+        Simplex GetIntersection()
         {
             return intersection.Get(this);
         }
@@ -211,6 +212,8 @@ public:
     VertsSet            borderVerts;
     std::vector<VertsSet> connectedComponentsBorders;
     std::vector<int>    connectedComponentsAccSubSize;
+    // reused by FindNode and FindPath (see IncidenceGraphAlgorithms)
+    SearchWorkspace<Node> searchWorkspace;
 
     IncidenceGraphT(int dim)
     {
@@ -451,6 +454,11 @@ public:
 
     void CalculateAccSubSpanningTree(AccTest *accTest)
     {
+        if (singleSearchFrontier)
+        {
+            CalculateAccSubSpanningTreeSingleFrontier(accTest, false);
+            return;
+        }
         int index = 0;
         std::queue<Node *> Q;
         for (typename std::vector<ConnectedComponent>::iterator i = connectedComponents.begin(); i != connectedComponents.end(); i++)
@@ -513,6 +521,11 @@ public:
 
     void CalculateAccSubSpanningTreeWithBorder(AccTest *accTest)
     {
+        if (singleSearchFrontier)
+        {
+            CalculateAccSubSpanningTreeSingleFrontier(accTest, true);
+            return;
+        }
         std::queue<Node *> Q;
         for (typename std::vector<ConnectedComponent>::iterator i = connectedComponents.begin(); i != connectedComponents.end(); i++)
         {
@@ -572,38 +585,175 @@ public:
         }
     }
 
+    // if set, nodes not in acyclic subset are searched by one breadth first
+    // search per connected component instead of searching from first node
+    // of every new part of acyclic subset (see
+    // CalculateAccSubSpanningTreeSingleFrontier)
+    static bool singleSearchFrontier;
+
 private:
 
-    void CreateAccSpanningTree(std::vector<Path> &paths, int maxAccSubID)
+    // search started in the first part of acyclic subset is continued
+    // after every part is grown, nodes of new part are added to its
+    // frontier. intersection with acyclic subset only grows, so nodes
+    // rejected once never have to be checked again and every node is
+    // visited once. paths go from the last node in acyclic subset on
+    // the way to the first node of next part, like those found by FindPath
+    void CalculateAccSubSpanningTreeSingleFrontier(AccTest *accTest, bool withBorder)
     {
-        char *addedToAccTree = new char[maxAccSubID];
-        memset(addedToAccTree, 0, sizeof(char) * maxAccSubID);
+        std::queue<Node *> Q;
+        for (typename std::vector<ConnectedComponent>::iterator i = connectedComponents.begin(); i != connectedComponents.end(); i++)
+        {
+            int accSubID = 0;
+            std::vector<Path> paths;
+            Node *first = withBorder ? FindNode(*i, FindNodeNotOnBorder<IncidenceGraphT>()) : *i;
+            int size = 0;
+            searchWorkspace.Begin();
+            std::vector<Node *> &frontier = searchWorkspace.queue;
+            int head = 0;
+            while (first != 0)
+            {
+                accSubID++;
+                first->IsInAccSub(true);
+                first->GetAccInfo().SetAccSubID(accSubID);
+                first->GetAccInfo().UpdateNeighboursAccIntersection();
+                if (!searchWorkspace.IsVisited(first))
+                {
+                    searchWorkspace.Visit(first, 0);
+                }
+                Q.push(first);
+                size++;
+                while (!Q.empty())
+                {
+                    Node *currentNode = Q.front();
+                    Q.pop();
+                    for (typename Edges::iterator j = currentNode->edges.begin(); j != currentNode->edges.end(); j++)
+                    {
+                        Node *neighbour = (*j)->GetNeighbour(currentNode);
+                        if (neighbour->IsInAccSub() || (withBorder && neighbour->IsOnBorder()))
+                        {
+                            continue;
+                        }
+                        if (neighbour->GetAccInfo().IsAccIntersectionAcyclic(accTest))
+                        {
+                            size++;
+                            neighbour->IsInAccSub(true);
+                            neighbour->GetAccInfo().SetAccSubID(accSubID);
+                            neighbour->GetAccInfo().UpdateNeighboursAccIntersection();
+                            if (!searchWorkspace.IsVisited(neighbour))
+                            {
+                                searchWorkspace.Visit(neighbour, 0);
+                            }
+                            Q.push(neighbour);
+                        }
+                    }
+                }
 
-        // we start building spanning tree by adding first node on the list
+                first = 0;
+                for (; head < (int)frontier.size(); head++)
+                {
+                    Node *node = frontier[head];
+                    // found node stays in frontier, it is expanded after
+                    // it is added to acyclic subset
+                    if (!node->IsInAccSub() && !node->GetAccInfo().HasIntersectionWithAccSub() && !(withBorder && node->IsOnBorder()))
+                    {
+                        first = node;
+                        break;
+                    }
+                    for (typename Edges::iterator j = node->edges.begin(); j != node->edges.end(); j++)
+                    {
+                        Node *neighbour = (*j)->GetNeighbour(node);
+                        if (!searchWorkspace.IsVisited(neighbour) && !(withBorder && neighbour->IsOnBorder()))
+                        {
+                            searchWorkspace.Visit(neighbour, node);
+                        }
+                    }
+                }
+                if (first != 0)
+                {
+                    Path path;
+                    Node *n = first;
+                    path.push_back(n);
+                    while (!n->IsInAccSub())
+                    {
+                        n = searchWorkspace.GetPred(n);
+                        assert(n != 0);
+                        path.push_back(n);
+                    }
+                    std::reverse(path.begin(), path.end());
+                    paths.push_back(path);
+                }
+            }
+
+            connectedComponentsAccSubSize.push_back(size);
+
+            if (paths.size() > 0)
+            {
+                CreateAccSpanningTree(paths, ++accSubID);
+            }
+        }
+    }
+
+    // every path connects two parts of acyclic subset and is added once
+    // one of its ends is in the tree. of such paths the one found first
+    // goes first, so paths ready to add are kept in heap by their indices
+    void CreateAccSpanningTree(std::vector<Path> &paths, int maxAccSubID)
+    {
         assert(paths.size() > 0);
-        addedToAccTree[paths[0].front()->GetAccInfo().GetAccSubID()] = true;
+        int pathsCount = paths.size();
 
-        while (!paths.empty())
+        // indices of paths incident to every part of acyclic subset
+        std::vector<int> offsets(maxAccSubID + 1, 0);
+        for (int i = 0; i < pathsCount; i++)
         {
-            Path path;
-            for (typename std::vector<Path>::iterator p = paths.begin(); p != paths.end(); p++)
+            offsets[paths[i].front()->GetAccInfo().GetAccSubID() + 1]++;
+            offsets[paths[i].back()->GetAccInfo().GetAccSubID() + 1]++;
+        }
+        for (int id = 0; id < maxAccSubID; id++)
+        {
+            offsets[id + 1] += offsets[id];
+        }
+        std::vector<int> incidentPaths(offsets[maxAccSubID]);
+        std::vector<int> positions(offsets.begin(), offsets.end() - 1);
+        for (int i = 0; i < pathsCount; i++)
+        {
+            incidentPaths[positions[paths[i].front()->GetAccInfo().GetAccSubID()]++] = i;
+            incidentPaths[positions[paths[i].back()->GetAccInfo().GetAccSubID()]++] = i;
+        }
+
+        std::vector<char> addedToAccTree(maxAccSubID, 0);
+        std::vector<char> queued(pathsCount, 0);
+        std::priority_queue<int, std::vector<int>, std::greater<int> > readyPaths;
+
+        // we start building spanning tree by adding first node on the list
+        int addedID = paths[0].front()->GetAccInfo().GetAccSubID();
+        while (true)
+        {
+            addedToAccTree[addedID] = 1;
+            for (int i = offsets[addedID]; i < offsets[addedID + 1]; i++)
             {
-                if (addedToAccTree[(*p).front()->GetAccInfo().GetAccSubID()] || addedToAccTree[(*p).back()->GetAccInfo().GetAccSubID()])
+                if (!queued[incidentPaths[i]])
                 {
-                    path = *p;
-                    paths.erase(p);
-                    break;
+                    queued[incidentPaths[i]] = 1;
+                    readyPaths.push(incidentPaths[i]);
                 }
             }
+            if (readyPaths.empty())
+            {
+                break;
+            }
+
+            Path &path = paths[readyPaths.top()];
+            readyPaths.pop();
             assert(!addedToAccTree[path.front()->GetAccInfo().GetAccSubID()] || !addedToAccTree[path.back()->GetAccInfo().GetAccSubID()]);
             // we do this to ensure that last node on path is not yet added
             // to acyclic spanning tree (by the way we construct paths we
             // are sure that in that case first node is added to tree)
             if (addedToAccTree[path.back()->GetAccInfo().GetAccSubID()])
             {
-                path.reverse();
+                std::reverse(path.begin(), path.end());
             }
-            addedToAccTree[path.back()->GetAccInfo().GetAccSubID()] = 1;
+            addedID = path.back()->GetAccInfo().GetAccSubID();
 
             typename Path::reverse_iterator current = path.rbegin();
             typename Path::reverse_iterator next = current;
@@ -632,7 +782,6 @@ private:
                 next++;
             }
         }
-        delete [] addedToAccTree;
     }
     
 public:
@@ -1041,6 +1190,9 @@ private:
 
 };
 
+template <typename Traits, template<typename> class IntersectionInfoT, template<typename> class AccInfoT>
+bool IncidenceGraphT<Traits, IntersectionInfoT, AccInfoT>::singleSearchFrontier = false;
+
 ////////////////////////////////////////////////////////////////////////////////
 
 #endif /* INCIDENCEGRAPH_HPP */
@@ -12,8 +12,7 @@
 #ifndef INCIDENCEGRAPHALGORITHMS_HPP
 #define INCIDENCEGRAPHALGORITHMS_HPP
 
-#include <queue>
-#include <map>
+#include <vector>
 #include <algorithm>
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -64,46 +63,87 @@ public:
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// reusable state of breadth first searches in one incidence graph.
+// visited nodes are stamped with current epoch at their indices, so
+// nothing has to be cleared after search. predecessors are kept in array
+// indexed by node indices, which have to be unique within the graph
+template <typename Node>
+class SearchWorkspace
+{
+    std::vector<unsigned int>   stamps;
+    std::vector<Node *>         preds;
+    unsigned int                epoch;
+
+public:
+
+    std::vector<Node *>         queue;
+
+    SearchWorkspace() : epoch(0) { }
+
+    void Begin()
+    {
+        if (epoch == (unsigned int)(-1))
+        {
+            std::fill(stamps.begin(), stamps.end(), 0);
+            epoch = 0;
+        }
+        epoch++;
+        queue.clear();
+    }
+
+    bool IsVisited(Node *node)
+    {
+        return (node->index < (int)stamps.size() && stamps[node->index] == epoch);
+    }
+
+    Node *GetPred(Node *node)
+    {
+        return preds[node->index];
+    }
+
+    void Visit(Node *node, Node *pred)
+    {
+        if (node->index >= (int)stamps.size())
+        {
+            int size = std::max(node->index + 1, (int)stamps.size() * 2);
+            stamps.resize(size, 0);
+            preds.resize(size, 0);
+        }
+        stamps[node->index] = epoch;
+        preds[node->index] = pred;
+        queue.push_back(node);
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 template <typename IncidenceGraph, template<typename> class FindOptions>
 typename IncidenceGraph::Node *FindNode(typename IncidenceGraph::ConnectedComponent connectedComponent, FindOptions<IncidenceGraph> findOptions)
 {
     typedef typename IncidenceGraph::Node Node;
-    typedef typename IncidenceGraph::Nodes Nodes;
     typedef typename IncidenceGraph::Edges Edges;
 
-    Nodes tmp;
-    std::queue<Node *> Q;
-    tmp.push_back(connectedComponent);
-    connectedComponent->IsHelperFlag1(true);
-    Q.push(connectedComponent);
-    Node *foundNode = 0;
-    while (foundNode == 0 && !Q.empty())
+    SearchWorkspace<Node> &workspace = connectedComponent->GetParentGraph()->searchWorkspace;
+    std::vector<Node *> &Q = workspace.queue;
+    workspace.Begin();
+    workspace.Visit(connectedComponent, 0);
+    for (int head = 0; head < (int)Q.size(); head++)
     {
-        Node *currentNode = Q.front();
-        Q.pop();
+        Node *currentNode = Q[head];
         if (findOptions.FoundNode(currentNode))
         {
-            foundNode = currentNode;
+            return currentNode;
         }
-        else
+        for (typename Edges::iterator edge = currentNode->edges.begin(); edge != currentNode->edges.end(); edge++)
         {
-            for (typename Edges::iterator edge = currentNode->edges.begin(); edge != currentNode->edges.end(); edge++)
+            Node *neighbour = (*edge)->GetNeighbour(currentNode);
+            if (!workspace.IsVisited(neighbour))
             {
-                Node *neighbour = (*edge)->GetNeighbour(currentNode);
-                if (!neighbour->IsHelperFlag1())
-                {
-                    tmp.push_back(neighbour);
-                    neighbour->IsHelperFlag1(true);
-                    Q.push(neighbour);
-                }
+                workspace.Visit(neighbour, currentNode);
             }
         }
     }
-    for (typename Nodes::iterator i = tmp.begin(); i != tmp.end(); i++)
-    {
-        (*i)->IsHelperFlag1(false);
-    }
-    return foundNode;
+    return 0;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -250,21 +290,17 @@ template <typename IncidenceGraph, template<typename> class FindOptions>
 typename IncidenceGraph::Path FindPath(typename IncidenceGraph::Node *firstNode, FindOptions<IncidenceGraph> findOptions)
 {
     typedef typename IncidenceGraph::Node Node;
-    typedef typename IncidenceGraph::Nodes Nodes;
     typedef typename IncidenceGraph::Edges Edges;
     typedef typename IncidenceGraph::Path Path;
 
-    std::queue<Node *> Q;
-    Nodes tmp;
-    firstNode->IsHelperFlag1(true);
-    Q.push(firstNode);
-    tmp.push_back(firstNode);
+    SearchWorkspace<Node> &workspace = firstNode->GetParentGraph()->searchWorkspace;
+    std::vector<Node *> &Q = workspace.queue;
+    workspace.Begin();
+    workspace.Visit(firstNode, 0);
     Node *foundNode = 0;
-    std::map<Node *, Node *> pred;
-    while (!Q.empty() && foundNode == 0)
+    for (int head = 0; head < (int)Q.size() && foundNode == 0; head++)
     {
-        Node *node = Q.front();
-        Q.pop();
+        Node *node = Q[head];
         if (findOptions.FoundNode(node))
         {
             foundNode = node;
@@ -274,33 +310,26 @@ typename IncidenceGraph::Path FindPath(typename IncidenceGraph::Node *firstNode,
             for (typename Edges::iterator edge = node->edges.begin(); edge != node->edges.end(); edge++)
             {
                 Node *neighbour = (*edge)->GetNeighbour(node);
-                if (!neighbour->IsHelperFlag1() && findOptions.IsValidNeighbour(neighbour))
+                if (!workspace.IsVisited(neighbour) && findOptions.IsValidNeighbour(neighbour))
                 {
-                    Q.push(neighbour);
-                    tmp.push_back(neighbour);
-                    neighbour->IsHelperFlag1(true);
-                    pred[neighbour] = node;
+                    workspace.Visit(neighbour, node);
                 }
             }
         }
     }
 
-    for (typename Nodes::iterator i = tmp.begin(); i != tmp.end(); i++)
-    {
-        (*i)->IsHelperFlag1(false);
-    }
-
     Path path;
     if (foundNode != 0)
     {
-        path.push_front(foundNode);
+        path.push_back(foundNode);
         Node *n = foundNode;
         while (n != firstNode && !findOptions.EndOfPath(n))
         {
-            n = pred[n];
-            path.push_front(n);
+            n = workspace.GetPred(n);
+            path.push_back(n);
             assert(n != 0);
         }
+        std::reverse(path.begin(), path.end());
     }
     return path;
 }
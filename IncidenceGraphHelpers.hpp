@@ -255,6 +255,27 @@ public:
         delete pg;
         return ig;
     }
+
+    // packs are joined by processes computing them
+    template <typename PartitionGraph>
+    static IncidenceGraph *CreateAndCalculateAccSubDistributed(SimplexList &simplexList, int packsCount, AccSubAlgorithm accSubAlgorithm, AccTest *accTest)
+    {
+        PartitionGraph *pg = new PartitionGraph(simplexList, packsCount, accSubAlgorithm, accTest, typename PartitionGraph::DistributedJoin());
+        IncidenceGraph *ig = pg->GetIncidenceGraph();
+        delete pg;
+        return ig;
+    }
+
+    // packs are read from binary file by processes computing them,
+    // simplices of returned graph are stored in simplexList
+    template <typename PartitionGraph>
+    static IncidenceGraph *CreateAndCalculateAccSubDistLocalInput(const std::string &filename, SimplexList &simplexList, int packsCount, AccSubAlgorithm accSubAlgorithm, AccTest *accTest)
+    {
+        PartitionGraph *pg = new PartitionGraph(filename, simplexList, packsCount, accSubAlgorithm, accTest, typename PartitionGraph::LocalInput());
+        IncidenceGraph *ig = pg->GetIncidenceGraph();
+        delete pg;
+        return ig;
+    }
 };
 
 #endif	/* INCIDENCEGRAPHHELPERS_HPP */
@@ -59,5 +59,24 @@ public:
 
 };
 
+// native integer flags for higher dimensions, e.g. uint64_t (dim <= 5)
+// or unsigned __int128 (dim <= 6), instead of looping over words
+template <typename FlagsType>
+class IncidenceGraphTraitsFlags
+{
+public:
+
+    typedef int                             Vertex;
+    typedef std::set<Vertex>                VertsSet;
+    typedef SimplexT<Vertex>                Simplex;
+    typedef std::vector<Simplex>            SimplexList;
+    typedef Simplex *                       SimplexPtr;
+    typedef std::vector<SimplexPtr>         SimplexPtrList;
+    typedef FlagsType                       IntersectionFlags;
+    typedef SimplexNormalizationNone<Vertex, Simplex> SimplexNormalization;
+    typedef AccSubAlgorithmType             AccSubAlgorithm;
+
+};
+
 #endif	/* INCIDENCEGRAPHTRAITS_H */
 
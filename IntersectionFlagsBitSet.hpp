@@ -14,6 +14,10 @@
 
 #include <cassert>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 
 template <int N>
@@ -47,12 +51,77 @@ public:
     {
         dim = D,
         size = Min1<(1 << (D + 1)) / (8 * sizeof(unsigned int))>::value,
+        wordBits = 8 * sizeof(unsigned int),
     };
 
 private:
 
     unsigned int data[size];
 
+    // word-level operations on the underlying arrays. whole 128 bit
+    // blocks are processed with SSE2 (if available), the rest word by word
+
+    static void Or(unsigned int *c, const unsigned int *a, const unsigned int *b)
+    {
+        int i = 0;
+#ifdef __SSE2__
+        for (; i + 4 <= size; i += 4)
+        {
+            __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+            __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+            _mm_storeu_si128((__m128i *)(c + i), _mm_or_si128(x, y));
+        }
+#endif
+        for (; i < size; i++) c[i] = a[i] | b[i];
+    }
+
+    static void And(unsigned int *c, const unsigned int *a, const unsigned int *b)
+    {
+        int i = 0;
+#ifdef __SSE2__
+        for (; i + 4 <= size; i += 4)
+        {
+            __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+            __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+            _mm_storeu_si128((__m128i *)(c + i), _mm_and_si128(x, y));
+        }
+#endif
+        for (; i < size; i++) c[i] = a[i] & b[i];
+    }
+
+    // c = a & ~b
+    static void AndNot(unsigned int *c, const unsigned int *a, const unsigned int *b)
+    {
+        int i = 0;
+#ifdef __SSE2__
+        for (; i + 4 <= size; i += 4)
+        {
+            __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+            __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+            _mm_storeu_si128((__m128i *)(c + i), _mm_andnot_si128(y, x));
+        }
+#endif
+        for (; i < size; i++) c[i] = a[i] & ~b[i];
+    }
+
+    static bool IsZero(const unsigned int *a)
+    {
+        int i = 0;
+#ifdef __SSE2__
+        const __m128i zero = _mm_setzero_si128();
+        for (; i + 4 <= size; i += 4)
+        {
+            __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+            if (_mm_movemask_epi8(_mm_cmpeq_epi32(x, zero)) != 0xFFFF) return false;
+        }
+#endif
+        for (; i < size; i++)
+        {
+            if (a[i]) return false;
+        }
+        return true;
+    }
+
 public:
 
     IntersectionFlagsBitSet()
@@ -70,6 +139,16 @@ public:
         (*this) = a;
     }
 
+    // flags with only n-th bit set, built directly in the right word
+    // instead of shifting 1 to the left n times
+    static IntersectionFlagsBitSet Bit(int n)
+    {
+        assert(n >= 0 && n < size * wordBits);
+        IntersectionFlagsBitSet set;
+        set.data[n / wordBits] = 1u << (n % wordBits);
+        return set;
+    }
+
     IntersectionFlagsBitSet &operator=(const IntersectionFlagsBitSet &set)
     {
         for (int i = 0; i < size; i++) data[i] = set.data[i];
@@ -85,49 +164,75 @@ public:
 
     IntersectionFlagsBitSet &operator|=(const IntersectionFlagsBitSet &set)
     {
-        for (int i = 0; i < size; i++) data[i] |= set.data[i];
+        Or(data, data, set.data);
         return (*this);
     }
 
     IntersectionFlagsBitSet &operator&=(const IntersectionFlagsBitSet &set)
     {
-        for (int i = 0; i < size; i++) data[i] &= set.data[i];
+        And(data, data, set.data);
         return (*this);
     }
 
-    IntersectionFlagsBitSet operator~()
+    IntersectionFlagsBitSet operator~() const
     {
         IntersectionFlagsBitSet set;
         for (int i = 0; i < size; i++) set.data[i] = ~data[i];
         return set;
     }
 
-    IntersectionFlagsBitSet &operator<<(int a)
+    // this & ~set without creating negated copy
+    IntersectionFlagsBitSet AndNot(const IntersectionFlagsBitSet &set) const
+    {
+        IntersectionFlagsBitSet c;
+        AndNot(c.data, data, set.data);
+        return c;
+    }
+
+    // shifts move whole words first and then the remaining bits,
+    // so their cost doesn't depend on a
+    IntersectionFlagsBitSet operator<<(int a) const
     {
         assert(a >= 0);
-        while (a-- > 0)
+        IntersectionFlagsBitSet set;
+        int words = a / wordBits;
+        int bits = a % wordBits;
+        for (int i = size - 1; i >= words; i--)
         {
-            for (int i = size - 1; i >= 0; i--)
+            set.data[i] = data[i - words] << bits;
+            if (bits > 0 && i - words > 0)
             {
-                if (i > 0) data[i] = (data[i] << 1) | ((data[i - 1] & (1 << 31)) ? 1 : 0);
-                else data[i] = data[i] << 1;
+                set.data[i] |= data[i - words - 1] >> (wordBits - bits);
             }
         }
-        return (*this);
+        return set;
     }
 
-    IntersectionFlagsBitSet &operator>>(int a)
+    IntersectionFlagsBitSet operator>>(int a) const
     {
         assert(a >= 0);
-        while (a-- > 0)
+        IntersectionFlagsBitSet set;
+        int words = a / wordBits;
+        int bits = a % wordBits;
+        for (int i = 0; i < size - words; i++)
         {
-            for (int i = 0; i < size; i++)
+            set.data[i] = data[i + words] >> bits;
+            if (bits > 0 && i + words < size - 1)
             {
-                if (i < size - 1) data[i] = (data[i] >> 1) | ((data[i + 1] & 1) ? (1 << 31) : 0);
-                else data[i] = data[i] >> 1;
+                set.data[i] |= data[i + words + 1] << (wordBits - bits);
             }
         }
-        return (*this);
+        return set;
+    }
+
+    IntersectionFlagsBitSet &operator<<=(int a)
+    {
+        return (*this) = (*this) << a;
+    }
+
+    IntersectionFlagsBitSet &operator>>=(int a)
+    {
+        return (*this) = (*this) >> a;
     }
     
     IntersectionFlagsBitSet &operator++()
@@ -179,13 +284,21 @@ public:
 
     operator bool() const
     {
-        for (int i = 0; i < size; i++)
+        return !IsZero(data);
+    }
+
+    int PopCount() const
+    {
+        int count = 0;
+        int i = 0;
+        for (; i + 2 <= size; i += 2)
         {
-            if (data[i]) return true;
+            count += __builtin_popcountll(data[i] | ((unsigned long long)data[i + 1] << 32));
         }
-        return false;
+        for (; i < size; i++) count += __builtin_popcount(data[i]);
+        return count;
     }
-    
+
     int GetBufferSize() const
     {
         return size;
@@ -260,6 +373,7 @@ bool operator>(const IntersectionFlagsBitSet<D> &a, const IntersectionFlagsBitSe
 template <int D>
 inline bool operator==(const IntersectionFlagsBitSet<D> &a, int b)
 {
+    if (b == 0) return IntersectionFlagsBitSet<D>::IsZero(a.data);
     if (a.data[0] != (unsigned int)b) return false;
     for (int i = 1; i < IntersectionFlagsBitSet<D>::size; i++)
         if (a.data[i] != 0) return false;
@@ -269,6 +383,7 @@ inline bool operator==(const IntersectionFlagsBitSet<D> &a, int b)
 template <int D>
 inline bool operator!=(const IntersectionFlagsBitSet<D> &a, int b)
 {
+    if (b == 0) return !IntersectionFlagsBitSet<D>::IsZero(a.data);
     if (a.data[0] != (unsigned int)b) return true;
     for (int i = 1; i < IntersectionFlagsBitSet<D>::size; i++)
         if (a.data[i] != 0) return true;
@@ -279,7 +394,7 @@ template <int D>
 IntersectionFlagsBitSet<D> operator|(const IntersectionFlagsBitSet<D> &a, const IntersectionFlagsBitSet<D> &b)
 {
     IntersectionFlagsBitSet<D> c;
-    for (int i = 0; i < IntersectionFlagsBitSet<D>::size; i++) c.data[i] = a.data[i] | b.data[i];
+    IntersectionFlagsBitSet<D>::Or(c.data, a.data, b.data);
     return c;
 }
 
@@ -287,14 +402,14 @@ template <int D>
 IntersectionFlagsBitSet<D> operator&(const IntersectionFlagsBitSet<D> &a, const IntersectionFlagsBitSet<D> &b)
 {
     IntersectionFlagsBitSet<D> c;
-    for (int i = 0; i < IntersectionFlagsBitSet<D>::size; i++) c.data[i] = a.data[i] & b.data[i];
+    IntersectionFlagsBitSet<D>::And(c.data, a.data, b.data);
     return c;
 }
 
 template <int D>
 IntersectionFlagsBitSet<D> operator|(const IntersectionFlagsBitSet<D> &a, int b)
 {
-    IntersectionFlagsBitSet<D> c;
+    IntersectionFlagsBitSet<D> c = a;
     c.data[0] = a.data[0] | (unsigned int)b;
     return c;
 }
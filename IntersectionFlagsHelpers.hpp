@@ -6,6 +6,8 @@
 #ifndef INTERSECTIONFLAGSHELPERS_HPP
 #define	INTERSECTIONFLAGSHELPERS_HPP
 
+#include <stdint.h>
+
 template <typename IntersectionFlags>
 class IntersectionFlagsHelpers
 {
@@ -25,6 +27,23 @@ public:
     {
         intersectionFlags.WriteToBuffer(buffer, index);
     }
+
+    static int PopCount(const IntersectionFlags &intersectionFlags)
+    {
+        return intersectionFlags.PopCount();
+    }
+
+    // a & ~b
+    static IntersectionFlags AndNot(const IntersectionFlags &a, const IntersectionFlags &b)
+    {
+        return a.AndNot(b);
+    }
+
+    // flags with only n-th bit set
+    static IntersectionFlags Bit(int n)
+    {
+        return IntersectionFlags::Bit(n);
+    }
 };
 
 template <>
@@ -46,7 +65,109 @@ public:
     {
         buffer[index++] = (int)intersectionFlags;
     }
+
+    static int PopCount(const unsigned int &intersectionFlags)
+    {
+        return __builtin_popcount(intersectionFlags);
+    }
+
+    static unsigned int AndNot(const unsigned int &a, const unsigned int &b)
+    {
+        return a & ~b;
+    }
+
+    static unsigned int Bit(int n)
+    {
+        return (unsigned int)1 << n;
+    }
 };
 
+// 64 bit flags are enough for dim <= 5 (63 faces)
+template <>
+class IntersectionFlagsHelpers<uint64_t>
+{
+public:
+
+    static int GetBufferSize(const uint64_t &intersectionFlags)
+    {
+        return 2;
+    }
+
+    static void ReadFromBuffer(uint64_t &intersectionFlags, int *buffer, int &index)
+    {
+        intersectionFlags = (uint64_t)(unsigned int)buffer[index++];
+        intersectionFlags |= ((uint64_t)(unsigned int)buffer[index++]) << 32;
+    }
+
+    static void WriteToBuffer(const uint64_t &intersectionFlags, int *buffer, int &index)
+    {
+        buffer[index++] = (int)(unsigned int)intersectionFlags;
+        buffer[index++] = (int)(unsigned int)(intersectionFlags >> 32);
+    }
+
+    static int PopCount(const uint64_t &intersectionFlags)
+    {
+        return __builtin_popcountll(intersectionFlags);
+    }
+
+    static uint64_t AndNot(const uint64_t &a, const uint64_t &b)
+    {
+        return a & ~b;
+    }
+
+    static uint64_t Bit(int n)
+    {
+        return (uint64_t)1 << n;
+    }
+};
+
+#ifdef __SIZEOF_INT128__
+
+// 128 bit flags are enough for dim <= 6 (127 faces)
+template <>
+class IntersectionFlagsHelpers<unsigned __int128>
+{
+public:
+
+    static int GetBufferSize(const unsigned __int128 &intersectionFlags)
+    {
+        return 4;
+    }
+
+    static void ReadFromBuffer(unsigned __int128 &intersectionFlags, int *buffer, int &index)
+    {
+        intersectionFlags = 0;
+        for (int i = 0; i < 4; i++)
+        {
+            intersectionFlags |= ((unsigned __int128)(unsigned int)buffer[index++]) << (32 * i);
+        }
+    }
+
+    static void WriteToBuffer(const unsigned __int128 &intersectionFlags, int *buffer, int &index)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            buffer[index++] = (int)(unsigned int)(intersectionFlags >> (32 * i));
+        }
+    }
+
+    static int PopCount(const unsigned __int128 &intersectionFlags)
+    {
+        return __builtin_popcountll((uint64_t)intersectionFlags) + __builtin_popcountll((uint64_t)(intersectionFlags >> 64));
+    }
+
+    static unsigned __int128 AndNot(const unsigned __int128 &a, const unsigned __int128 &b)
+    {
+        return a & ~b;
+    }
+
+    static unsigned __int128 Bit(int n)
+    {
+        return (unsigned __int128)1 << n;
+    }
+};
+
+#endif
+
 #endif	/* INTERSECTIONFLAGSHELPERS_HPP */
 
@@ -15,6 +15,7 @@
 #include <string>
 #include <set>
 #include <algorithm>
+#include <iterator>
 #include <cassert>
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -57,6 +58,13 @@ public:
         (*this) = a;
     }
 
+    static IntersectionFlagsSet Bit(int n)
+    {
+        IntersectionFlagsSet set;
+        set.flagsSet.insert(T(n));
+        return set;
+    }
+
     IntersectionFlagsSet &operator=(const IntersectionFlagsSet<T> &set)
     {
         negated = set.negated;
@@ -132,10 +140,34 @@ public:
     {
         IntersectionFlagsSet set;
         set.flagsSet = flagsSet;
-        set.negated = ~negated;
+        set.negated = !negated;
         return set;
     }
 
+    IntersectionFlagsSet AndNot(const IntersectionFlagsSet &set) const
+    {
+        IntersectionFlagsSet result;
+        std::insert_iterator<std::set<T> > output(result.flagsSet, result.flagsSet.begin());
+        if (!negated && !set.negated)
+        {
+            std::set_difference(flagsSet.begin(), flagsSet.end(), set.flagsSet.begin(), set.flagsSet.end(), output);
+        }
+        else if (negated && set.negated)
+        {
+            std::set_difference(set.flagsSet.begin(), set.flagsSet.end(), flagsSet.begin(), flagsSet.end(), output);
+        }
+        else if (!negated && set.negated)
+        {
+            std::set_intersection(flagsSet.begin(), flagsSet.end(), set.flagsSet.begin(), set.flagsSet.end(), output);
+        }
+        else
+        {
+            result.negated = true;
+            std::set_union(flagsSet.begin(), flagsSet.end(), set.flagsSet.begin(), set.flagsSet.end(), output);
+        }
+        return result;
+    }
+
 public:
 
     IntersectionFlagsSet &operator<<(int a)
@@ -276,6 +308,13 @@ public:
         }
     }
 
+    int PopCount() const
+    {
+        // negated set is infinite, we can only count explicit flags
+        assert(!negated);
+        return flagsSet.size();
+    }
+
     int GetBufferSize() const
     {
         // negated + size + list of flags as ints
@@ -46,9 +46,11 @@ public:
         this->intersectionFlagsB = 0;
     }
 
-    Simplex &Get(Edge *edge)
+    // returned by value, graphs of different packs are processed
+    // in parallel so there can't be any shared buffer
+    Simplex Get(Edge *edge)
     {
-        static Simplex intersection;
+        Simplex intersection;
         Simplex::GetIntersection(edge->nodeA->simplex, edge->nodeB->simplex, intersection);
         return intersection;
     }
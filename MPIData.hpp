@@ -13,6 +13,9 @@
 #define	MPIDATA_HPP
 
 #include <set>
+#include <string>
+#include <vector>
+#include <utility>
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -108,6 +111,10 @@ public:
     int *GetBuffer() const { return buffer; }
     int GetSize() const { return size; }
 
+    // simplices are appended to simplexList and their vertices are
+    // assigned straight from the buffer, so every simplex is allocated
+    // once. border vertices are sorted in the buffer, so they are
+    // inserted at the end of the set
     void GetSimplexData(SimplexList &simplexList, std::set<Vertex> &borderVerts, int &accSubAlgorithm, int &accTestNumber)
     {
         int index = 0;
@@ -115,35 +122,25 @@ public:
         int simplexCount = buffer[index++];
         accSubAlgorithm = buffer[index++];
         accTestNumber = buffer[index++];
-        if (simplexSize == 0)
+        int first = simplexList.size();
+        simplexList.resize(first + simplexCount);
+        for (int i = 0; i < simplexCount; i++)
         {
-            for (int i = 0; i < simplexCount; i++)
-            {
-                int size = buffer[index++];
-                Simplex simplex;
-                for (int j = 0; j < size; j++)
-                {
-                    simplex.push_back(buffer[index++]);
-                }
-                simplexList.push_back(simplex);
-            }
-        }
-        else
-        {
-            for (int i = 0; i < simplexCount; i++)
-            {
-                Simplex simplex;
-                for (int j = 0; j < simplexSize; j++)
-                {
-                    simplex.push_back(buffer[index++]);
-                }
-                simplexList.push_back(simplex);
-            }
+            int size = (simplexSize == 0) ? buffer[index++] : simplexSize;
+            simplexList[first + i].assign(buffer + index, buffer + index + size);
+            index += size;
         }
+        ReadBorderVerts(borderVerts, index);
+    }
+
+private:
+
+    void ReadBorderVerts(std::set<Vertex> &borderVerts, int &index)
+    {
         int borderVertsCount = buffer[index++];
         for (int i = 0; i < borderVertsCount; i++)
         {
-            borderVerts.insert(buffer[index++]);
+            borderVerts.insert(borderVerts.end(), buffer[index++]);
         }
     }
 
@@ -151,6 +148,102 @@ public:
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// packs of binary file (see SimplexListBinary) read by receivers, only
+// ranges of their simplices and border vertices are sent
+template<typename IncidenceGraph>
+class MPILocalInputData
+{
+    typedef typename IncidenceGraph::Vertex Vertex;
+
+    int *buffer;
+    int size;
+
+public:
+
+    MPILocalInputData(int *buffer, int size)
+    {
+        this->buffer = buffer;
+        this->size = size;
+    }
+
+    MPILocalInputData(const std::string &filename, const std::vector<std::pair<int, int> > &ranges, const std::vector<const std::set<Vertex> *> &borders, int accSubAlgorithm, int accTestNumber)
+    {
+        // additional ints are:
+        // - accSubAlgorithm
+        // - accTest id
+        // - filename length
+        // - packs count
+        // and for every pack:
+        // - first simplex and simplices count
+        // - borderVerts size
+        size = filename.size() + 3 * ranges.size() + 4;
+        for (typename std::vector<const std::set<Vertex> *>::const_iterator b = borders.begin(); b != borders.end(); b++)
+        {
+            size += (*b)->size();
+        }
+        buffer = new int[size];
+
+        int index = 0;
+        buffer[index++] = accSubAlgorithm;
+        buffer[index++] = accTestNumber;
+        buffer[index++] = filename.size();
+        for (std::string::const_iterator c = filename.begin(); c != filename.end(); c++)
+        {
+            buffer[index++] = (*c);
+        }
+        buffer[index++] = ranges.size();
+        for (std::vector<std::pair<int, int> >::const_iterator r = ranges.begin(); r != ranges.end(); r++)
+        {
+            buffer[index++] = r->first;
+            buffer[index++] = r->second;
+        }
+        for (typename std::vector<const std::set<Vertex> *>::const_iterator b = borders.begin(); b != borders.end(); b++)
+        {
+            buffer[index++] = (*b)->size();
+            for (typename std::set<Vertex>::const_iterator v = (*b)->begin(); v != (*b)->end(); v++)
+            {
+                buffer[index++] = (*v);
+            }
+        }
+    }
+
+    ~MPILocalInputData()
+    {
+        delete [] buffer;
+    }
+
+    int *GetBuffer() const { return buffer; }
+    int GetSize() const { return size; }
+
+    void GetHeader(std::string &filename, int &accSubAlgorithm, int &accTestNumber)
+    {
+        int index = 0;
+        accSubAlgorithm = buffer[index++];
+        accTestNumber = buffer[index++];
+        int filenameLength = buffer[index++];
+        filename.assign(buffer + index, buffer + index + filenameLength);
+    }
+
+    // packs with indices first, first + step, first + 2 * step...
+    void GetPacks(int first, int step, std::vector<std::pair<int, int> > &ranges, std::vector<std::set<Vertex> > &borders)
+    {
+        int index = 3 + buffer[2];
+        int packsCount = buffer[index++];
+        int rangesIndex = index;
+        index += 2 * packsCount;
+        for (int i = 0; i < packsCount; i++)
+        {
+            int borderVertsCount = buffer[index++];
+            if (i >= first && (i - first) % step == 0)
+            {
+                ranges.push_back(std::pair<int, int>(buffer[rangesIndex + 2 * i], buffer[rangesIndex + 2 * i + 1]));
+                borders.push_back(std::set<Vertex>(buffer + index, buffer + index + borderVertsCount));
+            }
+            index += borderVertsCount;
+        }
+    }
+};
+
 template<typename IncidenceGraph>
 class MPIIncidenceGraphData
 {
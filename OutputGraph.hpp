@@ -12,6 +12,9 @@
 #ifndef OUTPUTGRAPH_HPP
 #define OUTPUTGRAPH_HPP
 
+#include <fstream>
+#include <string>
+
 template <typename IncidenceGraphType>
 class OutputGraphT
 {
@@ -41,129 +44,133 @@ public:
             subnodes.push_back(subnode);
             this->kappa.push_back(kappa);
         }
+    };
 
-        void GetSubnodes(std::vector<Node *> &nodes)
-        {
-            nodes.push_back(this);
-            for (typename Nodes::iterator i = subnodes.begin(); i != subnodes.end(); i++)
-            {
-                (*i)->GetSubnodes(nodes);
-            }
-        }
-        
-        Node *FindNodeWithSimplex(const Simplex &s)
+    typedef std::vector<Node *> Nodes;
+    Nodes nodes;
+
+    // receives nodes of output graph component by component (see Stream).
+    // indices of nodes are global and consecutive, faces of nodes are
+    // in the same component
+    class Sink
+    {
+    public:
+
+        virtual ~Sink() { }
+        virtual void AddNodes(const Nodes &nodes) = 0;
+    };
+
+    // writes every node in a separate line: index, dimension and pairs
+    // of face index and kappa
+    class FileSink : public Sink
+    {
+        std::ofstream output;
+
+    public:
+
+        FileSink(const char *filename) : output(filename)
         {
-            if (simplex == s)
-            {
-                return this;
-            }
-            for (typename Nodes::iterator i = subnodes.begin(); i != subnodes.end(); i++)
+            if (!output.is_open())
             {
-                Node *n = (*i)->FindNodeWithSimplex(s);
-                if (n != 0)
-                {
-                    return n;
-                }
+                throw std::string("Can't create file ") + filename;
             }
-            return 0;
         }
 
-        static Node *FindNodeWithSimplex(std::vector<Node *> nodes, const Simplex &s)
+        void AddNodes(const Nodes &nodes)
         {
-            for (typename Nodes::iterator i = nodes.begin(); i != nodes.end(); i++)
+            for (typename Nodes::const_iterator i = nodes.begin(); i != nodes.end(); i++)
             {
-                if ((*i)->simplex == s)
+                output<<(*i)->index<<" "<<((*i)->simplex.size() - 1);
+                for (int j = 0; j < (int)(*i)->subnodes.size(); j++)
                 {
-                    return (*i);
+                    output<<" "<<(*i)->subnodes[j]->index<<" "<<(*i)->kappa[j];
                 }
+                output<<std::endl;
             }
-            return 0;
-        }
-
-        static bool Sorter(const Node *a, const Node *b)
-        {
-            return (a->simplex.size() > b->simplex.size());
         }
     };
 
-    typedef std::vector<Node *> Nodes;
-    Nodes nodes;
-
+    // components of the reduced graph share no faces, so they are
+    // generated independently (in parallel in OpenMP builds) with local
+    // indices, which are then shifted by sizes of preceding components
     OutputGraphT(IncidenceGraph *ig)
     {
-        nodeIndex = 0;
         incidenceGraph = ig;
-        std::queue<typename IncidenceGraph::Node *> Q;
-        for (typename IncidenceGraph::Nodes::iterator i = ig->nodes.begin(); i != ig->nodes.end(); i++)
+        CreateMasksFlags();
+        std::vector<Component> components;
+        GetComponents(components);
+        int count = components.size();
+        std::vector<Part> parts(count);
+#ifdef USE_OMP
+        #pragma omp parallel for schedule(dynamic)
+#endif
+        for (int i = 0; i < count; i++)
+        {
+            GeneratePart(components[i], parts[i]);
+        }
+        std::vector<int> offsets(count + 1, 0);
+        for (int i = 0; i < count; i++)
         {
-            if ((*i)->IsInAccSub() || (*i)->IsAddedToOutput())
+            offsets[i + 1] = offsets[i] + parts[i].nodes.size();
+        }
+        nodes.resize(offsets[count]);
+#ifdef USE_OMP
+        #pragma omp parallel for schedule(dynamic)
+#endif
+        for (int i = 0; i < count; i++)
+        {
+            Nodes &partNodes = parts[i].nodes;
+            for (int j = 0; j < (int)partNodes.size(); j++)
             {
-                continue;
-            }
-            Q.push(*i);
-            (*i)->IsAddedToQueue(true);
-            while (!Q.empty())
-            {
-                typename IncidenceGraph::Node *currentNode = Q.front();
-                Q.pop();
-                // flags of already generated simplices
-                IntersectionFlags subnodesFlags = 0;
-                // generated faces
-                Nodes subnodes;
-                for (typename IncidenceGraph::Edges::iterator edge = currentNode->edges.begin(); edge != currentNode->edges.end(); edge++)
-                {
-                    typename IncidenceGraph::Node *neighbour = (*edge)->GetNeighbour(currentNode);
-                    if (!neighbour->IsInAccSub())
-                    {
-                        if (neighbour->IsAddedToOutput())
-                        {
-                            // if intresection is not in acyclic subset
-                            IntersectionFlags intersectionFlags = (*edge)->GetIntersectionFlags(currentNode);
-                            if (!currentNode->GetAccInfo().IsInsideAccIntersection(intersectionFlags))
-                            {
-                                Node *outputNode = ((Node *)neighbour->helpers.ptr)->FindNodeWithSimplex((*edge)->GetIntersection());
-                                assert(outputNode != 0);
-                                outputNode->GetSubnodes(subnodes);
-                                subnodesFlags |= intersectionFlags;
-                            }
-                        }
-                        else
-                        {
-                            if (!neighbour->IsAddedToQueue())
-                            {
-                                neighbour->IsAddedToQueue(true);
-                                Q.push(neighbour);
-                            }
-                        }
-                    }
-                }
-                currentNode->IsAddedToOutput(true);
-                // we have to make copy to prevent from changing simplex in base node
-                Simplex baseSimplex = *currentNode->simplex;
-                currentNode->helpers.ptr = GenerateNode(currentNode, baseSimplex, subnodes, subnodesFlags);
+                partNodes[j]->index += offsets[i];
+                nodes[offsets[i] + j] = partNodes[j];
             }
         }
     }
 
     OutputGraphT(const SimplexList &simplexList)
     {
-        nodeIndex = 0;
+        incidenceGraph = 0;
+        Part part;
         for (typename SimplexList::const_iterator i = simplexList.begin(); i != simplexList.end(); i++)
         {
-            Node *node = AddNode(*i);
-            if ((*i).size() > 1)
+            IntersectionFlags subnodesFlags = 0;
+            GenerateNodes(part, *i, 0, subnodesFlags);
+        }
+        nodes.swap(part.nodes);
+    }
+
+    // output graph is passed to sink component by component without
+    // creating whole graph. every component is deleted together with its
+    // incidence graph nodes right after it is passed, so in the end
+    // incidence graph is empty (acyclic subset is removed first)
+    static void Stream(IncidenceGraph *ig, Sink &sink)
+    {
+        OutputGraphT og;
+        og.incidenceGraph = ig;
+        og.CreateMasksFlags();
+        ig->RemoveAccSub();
+        std::vector<Component> components;
+        og.GetComponents(components);
+        // nodes and edges are owned by components from now on
+        typename IncidenceGraph::Nodes().swap(ig->nodes);
+        typename IncidenceGraph::Edges().swap(ig->edges);
+        int offset = 0;
+        for (typename std::vector<Component>::iterator c = components.begin(); c != components.end(); c++)
+        {
+            Part part;
+            og.GeneratePart(*c, part);
+            for (typename Nodes::iterator i = part.nodes.begin(); i != part.nodes.end(); i++)
             {
-                Simplex s = *i;
-                int kappa = 1;
-                for (typename Simplex::iterator j = s.begin(); j != s.end(); j++)
-                {
-                    Vertex vertex = (*j);
-                    j = s.erase(j);
-                    node->AddSubnode(FindOrAddNode(*i), kappa);
-                    j = s.insert(j, vertex);
-                    kappa = -kappa;
-                }
+                (*i)->index += offset;
+            }
+            offset += part.nodes.size();
+            sink.AddNodes(part.nodes);
+            for (typename Nodes::iterator i = part.nodes.begin(); i != part.nodes.end(); i++)
+            {
+                delete (*i);
             }
+            DeleteComponent(*c);
         }
     }
 
@@ -178,105 +185,319 @@ public:
 
 private:
 
-    int             nodeIndex;
-    IncidenceGraph  *incidenceGraph;
+    OutputGraphT() : incidenceGraph(0) { }
 
-    // using flahs we check if generated simplex is contained in acyclic subset
-    // if simplex has been already generated we're looking for it in neighbours
-    // baseNode - node with maximal simplex which given simplex is face of
-    // baseSimplex - simplex which we're generating node for
-    // generatedSubnodes - already generated faces
-    // subnodesFlags - flags of already generated faces
-    Node *GenerateNode(typename IncidenceGraph::Node *baseNode, Simplex &baseSimplex, Nodes &generatedSubnodes, IntersectionFlags &subnodesFlags)
+    // open addressing hash of generated nodes keyed by vertices of their
+    // simplices. faces are generated from sorted simplices with vertices
+    // in the same order, so every face has single vertices tuple
+    class FacesHash
     {
-        IntersectionFlags flags = incidenceGraph->configurationsFlags[baseNode->Normalize(baseSimplex)];
-        assert(flags != 0);
-
-        Node *newNode = 0;
+        std::vector<Node *>         slots;
+        std::vector<unsigned int>   hashes;
+        int                         count;
 
-        // if face is not inside acyclic intersection but has been already generated
-        // then we are looking for it in the list of already generated faces
-        // if subnodesFlags == 0 then no faces have been yet generated
-        // if (baseNode->GetAccInfo().IsDisjointWithAccIntersection(flags) && (subnodesFlags & flags) == flags)
-        if (!baseNode->GetAccInfo().IsInsideAccIntersection(flags) && (subnodesFlags & flags) == flags)
+        static unsigned int Hash(const Simplex &s)
         {
-            return Node::FindNodeWithSimplex(generatedSubnodes, baseSimplex);
+            unsigned int h = 2166136261u;
+            for (typename Simplex::const_iterator v = s.begin(); v != s.end(); v++)
+            {
+                h = (h ^ (unsigned int)(*v)) * 16777619u;
+            }
+            return h;
         }
-        // if face is not inside acyclic subset and has not been yet generated
-        // we generate new node and add it to the list of generated faces
-        // else if (baseNode->GetAccInfo().IsDisjointWithAccIntersection(flags)/* && (subnodesFlags & flags) == 0 */)
-        else if (!baseNode->GetAccInfo().IsInsideAccIntersection(flags)/* && (subnodesFlags & flags) == 0 */)
+
+        void Place(Node *node, unsigned int h)
         {
-            assert(baseSimplex.size() != 0);
-            newNode = AddNode(baseSimplex);
-            generatedSubnodes.push_back(newNode);
-            // we set flags only for given simplex (not included its faces)
-            subnodesFlags |= flags;
+            unsigned int mask = slots.size() - 1;
+            unsigned int i = h & mask;
+            while (slots[i] != 0)
+            {
+                i = (i + 1) & mask;
+            }
+            slots[i] = node;
+            hashes[i] = h;
         }
-        // if faces is completely contained in acyclic subset
-        // we do not generate nothing more
-        else if (baseNode->GetAccInfo().IsInsideAccIntersection(flags))
+
+    public:
+
+        FacesHash() : slots(16, (Node *)0), hashes(16, 0), count(0) { }
+
+        Node *Find(const Simplex &s) const
         {
+            unsigned int h = Hash(s);
+            unsigned int mask = slots.size() - 1;
+            for (unsigned int i = h & mask; slots[i] != 0; i = (i + 1) & mask)
+            {
+                if (hashes[i] == h && slots[i]->simplex == s)
+                {
+                    return slots[i];
+                }
+            }
             return 0;
         }
-        else /* if (!baseNode->GetAccInfo().IsDisjointWithAccIntersection(flags)) */
+
+        // node must not be in hash yet, table is kept at most half full
+        void Insert(Node *node)
         {
-            assert(false);
-            return 0;
+            if (2 * (count + 1) > (int)slots.size())
+            {
+                std::vector<Node *> oldSlots(slots.size() * 2, (Node *)0);
+                std::vector<unsigned int> oldHashes(hashes.size() * 2, 0);
+                oldSlots.swap(slots);
+                oldHashes.swap(hashes);
+                for (int i = 0; i < (int)oldSlots.size(); i++)
+                {
+                    if (oldSlots[i] != 0)
+                    {
+                        Place(oldSlots[i], oldHashes[i]);
+                    }
+                }
+            }
+            Place(node, Hash(node->simplex));
+            count++;
         }
+    };
 
-        assert(newNode != 0);
+    // nodes of connected component of the reduced graph in BFS order
+    typedef std::vector<typename IncidenceGraph::Node *> Component;
 
-        // if it is possible to generate lower dimensional faces
-        if (baseSimplex.size() > 1)
+    // nodes generated for single component, indexed from 0
+    struct Part
+    {
+        Nodes       nodes;
+        FacesHash   faces;
+        Simplex     face;
+    };
+
+    // face on the stack of GenerateNodes
+    struct Face
+    {
+        Node    *node;
+        int     mask;
+        int     position;
+        int     kappa;
+    };
+
+    IncidenceGraph                  *incidenceGraph;
+    // flags of faces of normalized simplex indexed by masks of positions
+    // of their vertices
+    std::vector<IntersectionFlags>  masksFlags;
+
+    void CreateMasksFlags()
+    {
+        int size = incidenceGraph->dim + 1;
+        masksFlags.resize(1 << size);
+        for (int mask = 1; mask < (1 << size); mask++)
         {
-            int kappa = 1;
-            for (typename Simplex::iterator i = baseSimplex.begin(); i != baseSimplex.end(); i++)
+            Simplex s;
+            for (int i = 0; i < size; i++)
             {
-                Vertex vertex = (*i);
-                i = baseSimplex.erase(i);
-                Node *subnode = GenerateNode(baseNode, baseSimplex, generatedSubnodes, subnodesFlags);
-                if (subnode != 0)
+                if (mask & (1 << i))
                 {
-                    newNode->AddSubnode(subnode, kappa);
+                    s.push_back(i);
                 }
-                i = baseSimplex.insert(i, vertex);
-                kappa = -kappa;
             }
+            masksFlags[mask] = incidenceGraph->configurationsFlags[s];
         }
+    }
 
-        return newNode;
+    void GetComponents(std::vector<Component> &components)
+    {
+        for (typename IncidenceGraph::Nodes::iterator i = incidenceGraph->nodes.begin(); i != incidenceGraph->nodes.end(); i++)
+        {
+            (*i)->IsAddedToQueue(false);
+        }
+        for (typename IncidenceGraph::Nodes::iterator i = incidenceGraph->nodes.begin(); i != incidenceGraph->nodes.end(); i++)
+        {
+            if ((*i)->IsInAccSub() || (*i)->IsAddedToOutput() || (*i)->IsAddedToQueue())
+            {
+                continue;
+            }
+            components.push_back(Component());
+            Component &component = components.back();
+            component.push_back(*i);
+            (*i)->IsAddedToQueue(true);
+            // component is used as a queue
+            for (int front = 0; front < (int)component.size(); front++)
+            {
+                typename IncidenceGraph::Node *currentNode = component[front];
+                for (typename IncidenceGraph::Edges::iterator edge = currentNode->edges.begin(); edge != currentNode->edges.end(); edge++)
+                {
+                    typename IncidenceGraph::Node *neighbour = (*edge)->GetNeighbour(currentNode);
+                    if (!neighbour->IsInAccSub() && !neighbour->IsAddedToOutput() && !neighbour->IsAddedToQueue())
+                    {
+                        neighbour->IsAddedToQueue(true);
+                        component.push_back(neighbour);
+                    }
+                }
+            }
+        }
     }
 
-    Node *AddNode(const Simplex &s)
+    // every edge is on lists of both its nodes, so it is taken only
+    // from the first one
+    static void DeleteComponent(Component &component)
     {
-        Node *n = new Node(nodeIndex++, s);
-        nodes.push_back(n);
-        return n;
+        typename IncidenceGraph::Edges edges;
+        for (typename Component::iterator i = component.begin(); i != component.end(); i++)
+        {
+            for (typename IncidenceGraph::Edges::iterator edge = (*i)->edges.begin(); edge != (*i)->edges.end(); edge++)
+            {
+                if ((*edge)->nodeA == (*i))
+                {
+                    edges.push_back(*edge);
+                }
+            }
+        }
+        for (typename IncidenceGraph::Edges::iterator edge = edges.begin(); edge != edges.end(); edge++)
+        {
+            delete (*edge);
+        }
+        for (typename Component::iterator i = component.begin(); i != component.end(); i++)
+        {
+            delete (*i);
+        }
+        Component().swap(component);
+    }
+
+    void GeneratePart(const Component &component, Part &part)
+    {
+        for (typename Component::const_iterator i = component.begin(); i != component.end(); i++)
+        {
+            typename IncidenceGraph::Node *currentNode = *i;
+            // flags of already generated simplices
+            IntersectionFlags subnodesFlags = 0;
+            for (typename IncidenceGraph::Edges::iterator edge = currentNode->edges.begin(); edge != currentNode->edges.end(); edge++)
+            {
+                typename IncidenceGraph::Node *neighbour = (*edge)->GetNeighbour(currentNode);
+                if (!neighbour->IsInAccSub() && neighbour->IsAddedToOutput())
+                {
+                    // if intresection is not in acyclic subset
+                    IntersectionFlags intersectionFlags = (*edge)->GetIntersectionFlags(currentNode);
+                    if (!currentNode->GetAccInfo().IsInsideAccIntersection(intersectionFlags))
+                    {
+                        assert(part.faces.Find((*edge)->GetIntersection()) != 0);
+                        subnodesFlags |= intersectionFlags;
+                    }
+                }
+            }
+            currentNode->IsAddedToOutput(true);
+            currentNode->helpers.ptr = GenerateNodes(part, *currentNode->simplex, currentNode, subnodesFlags);
+        }
     }
 
-    Node *FindOrAddNode(const Simplex &simplex)
+    // faces of baseSimplex are described by masks of positions of their
+    // vertices and generated depth first, in the same order as by
+    // removing vertices one by one in recursion. every new face is
+    // followed by its faces, faces already generated are not expanded.
+    // if baseNode is given, faces inside acyclic intersection are skipped
+    // and subnodesFlags tell which faces were already generated
+    // (see GetFace), otherwise faces are looked up in hash
+    Node *GenerateNodes(Part &part, const Simplex &baseSimplex, typename IncidenceGraph::Node *baseNode, IntersectionFlags &subnodesFlags)
     {
-        Node *n = Node::FindNodeWithSimplex(nodes, simplex);
-        if (n != 0)
+        int size = baseSimplex.size();
+        Face stack[sizeof(int) * 8];
+        bool created = false;
+        Node *root = GetFace(part, baseSimplex, baseNode, (1 << size) - 1, subnodesFlags, created);
+        if (!created)
         {
-            return n;
+            return root;
         }
-        Node *node = AddNode(simplex);
-        if (simplex.size() > 1)
+        int depth = 0;
+        stack[0].node = root;
+        stack[0].mask = (1 << size) - 1;
+        stack[0].position = 0;
+        stack[0].kappa = 1;
+        while (depth >= 0)
         {
-            Simplex s = simplex;
-            int kappa = 1;
-            for (typename Simplex::iterator j = s.begin(); j != s.end(); j++)
+            Face &current = stack[depth];
+            while (current.position < size && !(current.mask & (1 << current.position)))
+            {
+                current.position++;
+            }
+            // vertices have no faces
+            if (current.position == size || (current.mask & (current.mask - 1)) == 0)
+            {
+                depth--;
+                continue;
+            }
+            int mask = current.mask & ~(1 << current.position);
+            int kappa = current.kappa;
+            current.position++;
+            current.kappa = -current.kappa;
+            Node *subnode = GetFace(part, baseSimplex, baseNode, mask, subnodesFlags, created);
+            if (subnode == 0)
             {
-                Vertex vertex = (*j);
-                j = s.erase(j);
-                node->AddSubnode(FindOrAddNode(s), kappa);
-                j = s.insert(j, vertex);
-                kappa = -kappa;
+                continue;
+            }
+            current.node->AddSubnode(subnode, kappa);
+            if (created)
+            {
+                depth++;
+                stack[depth].node = subnode;
+                stack[depth].mask = mask;
+                stack[depth].position = 0;
+                stack[depth].kappa = 1;
             }
         }
-        return node;
+        return root;
+    }
+
+    // using flags we check if generated simplex is contained in acyclic
+    // subset. if simplex has been already generated (by this node or its
+    // neighbours) we're looking for it in hash
+    Node *GetFace(Part &part, const Simplex &baseSimplex, typename IncidenceGraph::Node *baseNode, int mask, IntersectionFlags &subnodesFlags, bool &created)
+    {
+        created = false;
+        IntersectionFlags flags = 0;
+        if (baseNode != 0)
+        {
+            flags = masksFlags[mask];
+            assert(flags != 0);
+            // if face is completely contained in acyclic subset
+            // we do not generate nothing more
+            if (baseNode->GetAccInfo().IsInsideAccIntersection(flags))
+            {
+                return 0;
+            }
+        }
+        Simplex &face = part.face;
+        face.clear();
+        for (int i = 0; i < (int)baseSimplex.size(); i++)
+        {
+            if (mask & (1 << i))
+            {
+                face.push_back(baseSimplex[i]);
+            }
+        }
+        if (baseNode != 0)
+        {
+            // if subnodesFlags == 0 then no faces have been yet generated
+            if ((subnodesFlags & flags) == flags)
+            {
+                return part.faces.Find(face);
+            }
+            // we set flags only for given simplex (not included its faces)
+            subnodesFlags |= flags;
+        }
+        else
+        {
+            Node *node = part.faces.Find(face);
+            if (node != 0)
+            {
+                return node;
+            }
+        }
+        created = true;
+        return AddNode(part, face);
+    }
+
+    Node *AddNode(Part &part, const Simplex &s)
+    {
+        Node *n = new Node(part.nodes.size(), s);
+        part.nodes.push_back(n);
+        part.faces.Insert(n);
+        return n;
     }
 };
 
@@ -11,7 +11,9 @@
 #define PARTITIONGRAPH_HPP
 
 #include "AccSpanningTree.hpp"
+#include "SimplexListBinary.hpp"
 #include <cmath> // ceil
+#include <string>
 
 #ifdef ACCSUB_TRACE
 #include "Utils.hpp"
@@ -37,12 +39,13 @@ public:
     struct Node
     {
         SimplexPtrList      simplexPtrList;
-        std::set<Vertex>    verts;
+        std::vector<Vertex> verts; // sorted
         std::set<Vertex>    borderVerts;
         std::vector<Edge *> edges;
         IncidenceGraph      *ig;
-        VertexHash          H;
         int                 processRank;
+        // (first simplex, simplices count) in local input file
+        std::pair<int, int> simplexRange;
 
         Node()
         {
@@ -60,33 +63,35 @@ public:
             delete ig;
         }
 
-        void AddEdge(Edge *edge, Simplex &edgeVerts)
+        void AddEdge(Edge *edge)
         {
             edges.push_back(edge);
-            AddToBorder(edgeVerts);
         }
 
-        void AddToBorder(std::vector<Vertex> verts)
+        void AddVertex(const Vertex &v)
         {
-            borderVerts.insert(verts.begin(), verts.end());
+            verts.push_back(v);
         }
 
-        void CreateVertexHashForBorderNodes()
+        void SortVerts()
         {
-            if (H.size() > 0)
+            std::sort(verts.begin(), verts.end());
+            verts.erase(std::unique(verts.begin(), verts.end()), verts.end());
+        }
+
+        // simplices count times average size of vertex star in pack
+        float GetEstimatedCost()
+        {
+            if (verts.size() == 0)
             {
-                return;
+                return simplexPtrList.size();
             }
-            for (typename IncidenceGraph::Nodes::iterator node = ig->nodes.begin(); node != ig->nodes.end(); node++)
+            float incidences = 0;
+            for (typename SimplexPtrList::iterator s = simplexPtrList.begin(); s != simplexPtrList.end(); s++)
             {
-                if ((*node)->IsOnBorder())
-                {
-                    for (typename Simplex::iterator v = (*node)->simplex->begin(); v != (*node)->simplex->end(); v++)
-                    {
-                        H[*v].push_back(*node);
-                    }
-                }
+                incidences += (*s)->size();
             }
+            return simplexPtrList.size() * incidences / verts.size();
         }
     };
 
@@ -107,31 +112,56 @@ public:
 
     PartitionGraphT(SimplexList &simplexList, int packsCount, AccSubAlgorithm accSubAlgorithm, AccTest *accTest)
     {
-        this->incidenceGraph = new IncidenceGraph(Simplex::GetSimplexListDimension(simplexList));
-        this->initialSize = simplexList.size();
-        this->accSubAlgorithm = accSubAlgorithm;
-        this->accTest = accTest;
-        int packSize = (int)ceil(float(simplexList.size()) / packsCount);
-#ifdef ACCSUB_TRACE
-        std::cout<<"pack size: "<<packSize<<std::endl;
-        MemoryInfo::Print();
-#endif
-        PrepareDataPolicy<PartitionGraphT>::Prepare(simplexList, packSize);
+        CreatePacks(simplexList, packsCount, accSubAlgorithm, accTest);
+        CalculateIncidenceGraphs(nodes);
 #ifdef ACCSUB_TRACE
-        Timer::Update("preparing data");
+        Timer::Update("creating incidence graphs");
         MemoryInfo::Print();
 #endif
-        DivideData(simplexList, packSize);
+        if (mergeTreeLevels > 0)
+        {
+            MergeTree();
+        }
+        AccSpanningTreeT<PartitionGraphT> *ast = new AccSpanningTreeT<PartitionGraphT>(this);
+        CalculateIncidenceGraphs(isolatedNodes);
 #ifdef ACCSUB_TRACE
-        Timer::Update("dividing data");
+        Timer::Update("creating isolated incidence graphs");
         MemoryInfo::Print();
 #endif
-        CreateDataEdges();
+        CombineGraphs();
+        ast->JoinAccSubsets();
+        delete ast;
+    }
+
+    struct DistributedJoin { };
+
+    // packs are computed and kept by other processes which also join
+    // acyclic subsets, only reduced graphs are sent back and combined.
+    // computations policy has to provide ComputeDistributed (see
+    // ComputationsParallelMPI)
+    PartitionGraphT(SimplexList &simplexList, int packsCount, AccSubAlgorithm accSubAlgorithm, AccTest *accTest, DistributedJoin)
+    {
+        CreatePacks(simplexList, packsCount, accSubAlgorithm, accTest);
+        ComputationsPolicy<PartitionGraphT>::ComputeDistributed(nodes, isolatedNodes, accSubAlgorithm, accTest);
 #ifdef ACCSUB_TRACE
-        Timer::Update("creating data connections");
+        Timer::Update("creating incidence graphs");
         MemoryInfo::Print();
 #endif
-        CalculateIncidenceGraphs(nodes);
+        CombineGraphs();
+    }
+
+    struct LocalInput { };
+
+    // master does not keep input simplices. packs are consecutive ranges
+    // of simplices in binary file (see SimplexListBinary), which is read
+    // once to find vertices of packs, and are computed by processes
+    // reading their ranges. simplices of reduced graphs are stored in
+    // simplexList. computations policy has to provide ComputeLocalInput
+    // (see ComputationsParallelMPI)
+    PartitionGraphT(const std::string &filename, SimplexList &simplexList, int packsCount, AccSubAlgorithm accSubAlgorithm, AccTest *accTest, LocalInput)
+    {
+        CreatePacks(filename, packsCount, accSubAlgorithm, accTest);
+        ComputationsPolicy<PartitionGraphT>::ComputeLocalInput(filename, nodes, simplexList, accSubAlgorithm, accTest);
 #ifdef ACCSUB_TRACE
         Timer::Update("creating incidence graphs");
         MemoryInfo::Print();
@@ -165,6 +195,25 @@ public:
 
     IncidenceGraph *GetIncidenceGraph() { return incidenceGraph; }
 
+    // packs with estimated cost greater than packSplitFactor times
+    // average cost are split in halves (0 - no splitting)
+    static float packSplitFactor;
+
+    // number of levels on which neighbouring packs are merged pairwise
+    // before graphs are combined (0 - no merging)
+    static int mergeTreeLevels;
+
+    // number of distinct vertices shared by at least two packs
+    int GetBorderVertsCount()
+    {
+        std::set<Vertex> borderVerts;
+        for (typename Nodes::iterator i = nodes.begin(); i != nodes.end(); i++)
+        {
+            borderVerts.insert((*i)->borderVerts.begin(), (*i)->borderVerts.end());
+        }
+        return borderVerts.size();
+    }
+
     Nodes nodes;
     Edges edges;
     Nodes isolatedNodes;
@@ -176,6 +225,52 @@ private:
     AccSubAlgorithm             accSubAlgorithm;
     AccTest                     *accTest;
 
+    // (vertex, pack index) pairs for every vertex of every pack, built
+    // by CreateVertsOwners and used by CreateDataEdges
+    typedef std::pair<Vertex, int> VertexOwner;
+    std::vector<VertexOwner>    vertsOwners;
+    // (vertex, owners count) pairs sorted by vertices, kept only for
+    // border vertices when packs are merged
+    std::vector<VertexOwner>    borderVertsOwners;
+
+    void CreatePacks(SimplexList &simplexList, int packsCount, AccSubAlgorithm accSubAlgorithm, AccTest *accTest)
+    {
+        this->incidenceGraph = new IncidenceGraph(Simplex::GetSimplexListDimension(simplexList));
+        this->initialSize = simplexList.size();
+        this->accSubAlgorithm = accSubAlgorithm;
+        this->accTest = accTest;
+        int packSize = (int)ceil(float(simplexList.size()) / packsCount);
+        // merged packs are computed from simplices of different packs,
+        // their intersections are found only for sorted vertices
+        if (mergeTreeLevels > 0)
+        {
+            for (typename SimplexList::iterator s = simplexList.begin(); s != simplexList.end(); s++)
+            {
+                std::sort(s->begin(), s->end());
+            }
+        }
+#ifdef ACCSUB_TRACE
+        std::cout<<"pack size: "<<packSize<<std::endl;
+        MemoryInfo::Print();
+#endif
+        PrepareDataPolicy<PartitionGraphT>::Prepare(simplexList, packSize);
+#ifdef ACCSUB_TRACE
+        Timer::Update("preparing data");
+        MemoryInfo::Print();
+#endif
+        DivideData(simplexList, packSize);
+#ifdef ACCSUB_TRACE
+        Timer::Update("dividing data");
+        MemoryInfo::Print();
+#endif
+        CreateDataEdges();
+#ifdef ACCSUB_TRACE
+        std::cout<<"border vertices: "<<GetBorderVertsCount()<<std::endl;
+        Timer::Update("creating data connections");
+        MemoryInfo::Print();
+#endif
+    }
+
     void DivideData(SimplexList &simplexList, int packSize)
     {
         Node *currentNode = new Node();
@@ -186,11 +281,12 @@ private:
             currentNode->simplexPtrList.push_back(&(*it));
             for (typename Simplex::const_iterator i = it->begin(); i != it->end(); i++)
             {
-                currentNode->verts.insert(*i);
+                currentNode->AddVertex(*i);
             }
             simplicesLeft--;
             if (simplicesLeft == 0)
             {
+                currentNode->SortVerts();
                 nodes.push_back(currentNode);
                 currentNode = new Node();
                 simplicesLeft = packSize;
@@ -199,30 +295,166 @@ private:
         }
         if (currentNode->simplexPtrList.size() > 0)
         {
+            currentNode->SortVerts();
             nodes.push_back(currentNode);
         }
         else
         {
             delete currentNode;
         }
+        if (packSplitFactor > 0)
+        {
+            SplitPacks();
+        }
+        CreateVertsOwners();
     }
 
-    void CreateDataEdges()
+    void CreatePacks(const std::string &filename, int packsCount, AccSubAlgorithm accSubAlgorithm, AccTest *accTest)
+    {
+        typename SimplexListBinary<Simplex>::Reader reader(filename.c_str());
+        this->initialSize = reader.GetCount();
+        this->accSubAlgorithm = accSubAlgorithm;
+        this->accTest = accTest;
+        int packSize = (int)ceil(float(reader.GetCount()) / packsCount);
+#ifdef ACCSUB_TRACE
+        std::cout<<"pack size: "<<packSize<<std::endl;
+        MemoryInfo::Print();
+#endif
+        // only simplices of current pack are kept in memory
+        SimplexList simplexList;
+        int first = reader.GetCurrent();
+        int dim = 0;
+        while (reader.ReadNext(simplexList, packSize))
+        {
+            Node *node = new Node();
+            node->simplexRange = std::pair<int, int>(first, simplexList.size());
+            for (typename SimplexList::iterator s = simplexList.begin(); s != simplexList.end(); s++)
+            {
+                for (typename Simplex::const_iterator v = s->begin(); v != s->end(); v++)
+                {
+                    node->AddVertex(*v);
+                }
+            }
+            if (first == 0)
+            {
+                dim = Simplex::GetSimplexListDimension(simplexList);
+            }
+            node->SortVerts();
+            nodes.push_back(node);
+            first = reader.GetCurrent();
+        }
+        this->incidenceGraph = new IncidenceGraph(dim);
+        CreateVertsOwners();
+#ifdef ACCSUB_TRACE
+        Timer::Update("dividing data");
+        MemoryInfo::Print();
+#endif
+        CreateDataEdges();
+#ifdef ACCSUB_TRACE
+        std::cout<<"border vertices: "<<GetBorderVertsCount()<<std::endl;
+        Timer::Update("creating data connections");
+        MemoryInfo::Print();
+#endif
+    }
+
+    void CreateVertsOwners()
     {
+        for (int i = 0; i < (int)nodes.size(); i++)
+        {
+            for (typename std::vector<Vertex>::iterator v = nodes[i]->verts.begin(); v != nodes[i]->verts.end(); v++)
+            {
+                vertsOwners.push_back(VertexOwner(*v, i));
+            }
+        }
+    }
+
+    void SplitPacks()
+    {
+        float averageCost = 0;
         for (typename Nodes::iterator i = nodes.begin(); i != nodes.end(); i++)
         {
-            for (typename Nodes::iterator j = i + 1; j != nodes.end(); j++)
+            averageCost += (*i)->GetEstimatedCost();
+        }
+        averageCost /= nodes.size();
+        float maxCost = averageCost * packSplitFactor;
+        Nodes splitNodes;
+        // halves are put back on stack, so order of simplices is kept
+        Nodes stack(nodes.rbegin(), nodes.rend());
+        while (!stack.empty())
+        {
+            Node *node = stack.back();
+            stack.pop_back();
+            int size = node->simplexPtrList.size();
+            if (size < 2 || node->GetEstimatedCost() <= maxCost)
+            {
+                splitNodes.push_back(node);
+                continue;
+            }
+            Node *halves[2] = { new Node(), new Node() };
+            for (int i = 0; i < size; i++)
             {
-                Simplex intersection;
-                GetSortedIntersectionOfUnsortedSets(intersection, (*i)->verts, (*j)->verts);
-                if (intersection.size() > 0)
+                Node *half = halves[(i < size / 2) ? 0 : 1];
+                Simplex *s = node->simplexPtrList[i];
+                half->simplexPtrList.push_back(s);
+                for (typename Simplex::const_iterator v = s->begin(); v != s->end(); v++)
                 {
-                    Edge *edge = new Edge(*i, *j);
-                    edges.push_back(edge);
-                    (*i)->AddEdge(edge, intersection);
-                    (*j)->AddEdge(edge, intersection);
+                    half->AddVertex(*v);
                 }
             }
+            halves[0]->SortVerts();
+            halves[1]->SortVerts();
+            stack.push_back(halves[1]);
+            stack.push_back(halves[0]);
+            delete node;
+        }
+#ifdef ACCSUB_TRACE
+        std::cout<<"packs after splitting: "<<splitNodes.size()<<" (was "<<nodes.size()<<")"<<std::endl;
+#endif
+        nodes.swap(splitNodes);
+    }
+
+    // vertices owned by more than one pack are border vertices and every
+    // pair of their owners is connected by an edge
+    void CreateDataEdges()
+    {
+        std::sort(vertsOwners.begin(), vertsOwners.end());
+        std::vector<std::pair<int, int> > connections;
+        typename std::vector<VertexOwner>::iterator first = vertsOwners.begin();
+        while (first != vertsOwners.end())
+        {
+            typename std::vector<VertexOwner>::iterator last = first + 1;
+            while (last != vertsOwners.end() && last->first == first->first)
+            {
+                last++;
+            }
+            if (last - first > 1)
+            {
+                if (mergeTreeLevels > 0)
+                {
+                    borderVertsOwners.push_back(VertexOwner(first->first, last - first));
+                }
+                for (typename std::vector<VertexOwner>::iterator i = first; i != last; i++)
+                {
+                    // vertices are visited in ascending order
+                    nodes[i->second]->borderVerts.insert(nodes[i->second]->borderVerts.end(), first->first);
+                    for (typename std::vector<VertexOwner>::iterator j = i + 1; j != last; j++)
+                    {
+                        connections.push_back(std::pair<int, int>(i->second, j->second));
+                    }
+                }
+            }
+            first = last;
+        }
+        std::vector<VertexOwner>().swap(vertsOwners);
+
+        std::sort(connections.begin(), connections.end());
+        connections.erase(std::unique(connections.begin(), connections.end()), connections.end());
+        for (typename std::vector<std::pair<int, int> >::iterator c = connections.begin(); c != connections.end(); c++)
+        {
+            Edge *edge = new Edge(nodes[c->first], nodes[c->second]);
+            edges.push_back(edge);
+            nodes[c->first]->AddEdge(edge);
+            nodes[c->second]->AddEdge(edge);
         }
     }
 
@@ -231,69 +463,345 @@ private:
         ComputationsPolicy<PartitionGraphT>::Compute(sourceNodes, accSubAlgorithm, accTest);
     }
 
+    // vertex of border simplex with index of its pack and index of
+    // simplex in combined graph
+    struct BorderEntry
+    {
+        Vertex  vertex;
+        int     pack;
+        int     node;
+
+        BorderEntry() { }
+        BorderEntry(const Vertex &v, int p, int n) : vertex(v), pack(p), node(n) { }
+
+        bool operator<(const BorderEntry &e) const
+        {
+            if (vertex != e.vertex) return vertex < e.vertex;
+            if (pack != e.pack) return pack < e.pack;
+            return node < e.node;
+        }
+    };
+
+    typedef std::pair<int, int> NodesPair;
+
     void CombineGraphs()
     {
-        for (typename Edges::iterator edge = edges.begin(); edge != edges.end(); edge++)
+        // moving all nodes and edges to a single incidence graph,
+        // every pack gets its own range of combined vectors
+        Nodes packs(nodes);
+        packs.insert(packs.end(), isolatedNodes.begin(), isolatedNodes.end());
+        int packsCount = packs.size();
+        std::vector<int> nodesOffsets(packsCount + 1, 0);
+        std::vector<int> edgesOffsets(packsCount + 1, 0);
+        for (int i = 0; i < packsCount; i++)
+        {
+            nodesOffsets[i + 1] = nodesOffsets[i] + packs[i]->ig->nodes.size();
+            edgesOffsets[i + 1] = edgesOffsets[i] + packs[i]->ig->edges.size();
+        }
+        incidenceGraph->nodes.resize(nodesOffsets[packsCount]);
+        incidenceGraph->edges.resize(edgesOffsets[packsCount]);
+#ifdef USE_OMP
+        #pragma omp parallel for schedule(dynamic)
+#endif
+        for (int i = 0; i < packsCount; i++)
+        {
+            IncidenceGraph *ig = packs[i]->ig;
+            std::copy(ig->nodes.begin(), ig->nodes.end(), incidenceGraph->nodes.begin() + nodesOffsets[i]);
+            std::copy(ig->edges.begin(), ig->edges.end(), incidenceGraph->edges.begin() + edgesOffsets[i]);
+            // indices of nodes have to be unique within graph, paths are
+            // searched in combined graph when acyclic subsets are joined
+            int index = nodesOffsets[i];
+            for (typename IncidenceGraph::Nodes::iterator node = ig->nodes.begin(); node != ig->nodes.end(); node++)
+            {
+                (*node)->SetParentGraph(incidenceGraph);
+                (*node)->index = index++;
+            }
+            ig->nodes.clear();
+            ig->edges.clear();
+        }
+
+#ifdef ACCSUB_TRACE
+        Timer::Update("moving simplices to single incidence graph");
+#endif
+
+        // isolated packs have no border
+        ConnectBorderNodes(incidenceGraph, nodesOffsets, nodes.size());
+
+#ifdef ACCSUB_TRACE
+        std::cout<<"total simplices after connecting graphs: "<<incidenceGraph->nodes.size()<<std::endl;
+        std::cout<<"reduced acyclic subset size: "<<(initialSize - incidenceGraph->nodes.size())<<" ("<<((initialSize - incidenceGraph->nodes.size()) * 100 / initialSize)<<"%)"<<std::endl;
+        Timer::Update("connecting simplices on border");
+#endif
+    }
+
+    // neighbouring packs are merged pairwise on every level. border is
+    // shrunk to vertices still shared with other packs and acyclic subset
+    // of merged pack is computed again (like for any other pack), so it
+    // can grow over the former common border
+    void MergeTree()
+    {
+        for (int level = 0; level < mergeTreeLevels && edges.size() > 0; level++)
         {
-            typename IncidenceGraph::Nodes nodesA = (*edge)->nodeA->ig->nodes;
-            (*edge)->nodeB->CreateVertexHashForBorderNodes();
-            VertexHash HB = (*edge)->nodeB->H;
+            int packsCount = nodes.size();
+            std::map<Node *, int> packsIndices;
+            for (int i = 0; i < packsCount; i++)
+            {
+                packsIndices[nodes[i]] = i;
+            }
 
-            for (typename IncidenceGraph::Nodes::iterator node = nodesA.begin(); node != nodesA.end(); node++)
+            // greedy matching, packs sharing more border vertices go first
+            std::vector<std::pair<int, int> > weightedEdges;
+            for (int i = 0; i < (int)edges.size(); i++)
             {
-                if (!(*node)->IsOnBorder())
+                std::vector<Vertex> commonBorder;
+                std::set_intersection(edges[i]->nodeA->borderVerts.begin(), edges[i]->nodeA->borderVerts.end(), edges[i]->nodeB->borderVerts.begin(), edges[i]->nodeB->borderVerts.end(), std::back_inserter(commonBorder));
+                weightedEdges.push_back(std::pair<int, int>(-(int)commonBorder.size(), i));
+            }
+            std::sort(weightedEdges.begin(), weightedEdges.end());
+            std::vector<int> partners(packsCount, -1);
+            std::vector<std::pair<int, int> > pairs;
+            for (std::vector<std::pair<int, int> >::iterator i = weightedEdges.begin(); i != weightedEdges.end(); i++)
+            {
+                int a = packsIndices[edges[i->second]->nodeA];
+                int b = packsIndices[edges[i->second]->nodeB];
+                if (partners[a] == -1 && partners[b] == -1)
                 {
-                    continue;
+                    partners[a] = b;
+                    partners[b] = a;
+                    pairs.push_back(std::pair<int, int>(std::min(a, b), std::max(a, b)));
                 }
-                for (typename Simplex::iterator v = (*node)->simplex->begin(); v != (*node)->simplex->end(); v++)
+            }
+
+            // merged packs are ordered like their first parts
+            std::sort(pairs.begin(), pairs.end());
+
+            // merged packs, border vertices owned only by merged pair
+            // are no longer on border
+            int pairsCount = pairs.size();
+            Nodes mergedNodes(pairsCount);
+            for (int i = 0; i < pairsCount; i++)
+            {
+                Node *packA = nodes[pairs[i].first];
+                Node *packB = nodes[pairs[i].second];
+                Node *mergedPack = new Node(packA->simplexPtrList);
+                mergedPack->simplexPtrList.insert(mergedPack->simplexPtrList.end(), packB->simplexPtrList.begin(), packB->simplexPtrList.end());
+                std::set_union(packA->verts.begin(), packA->verts.end(), packB->verts.begin(), packB->verts.end(), std::back_inserter(mergedPack->verts));
+                std::vector<Vertex> commonBorder;
+                std::set_intersection(packA->borderVerts.begin(), packA->borderVerts.end(), packB->borderVerts.begin(), packB->borderVerts.end(), std::back_inserter(commonBorder));
+                for (typename std::vector<Vertex>::iterator v = commonBorder.begin(); v != commonBorder.end(); v++)
+                {
+                    GetBorderVertexOwner(*v)->second--;
+                }
+                mergedNodes[i] = mergedPack;
+            }
+            for (int i = 0; i < pairsCount; i++)
+            {
+                Node *packA = nodes[pairs[i].first];
+                Node *packB = nodes[pairs[i].second];
+                std::vector<Vertex> border;
+                std::set_union(packA->borderVerts.begin(), packA->borderVerts.end(), packB->borderVerts.begin(), packB->borderVerts.end(), std::back_inserter(border));
+                for (typename std::vector<Vertex>::iterator v = border.begin(); v != border.end(); v++)
                 {
-                    typename IncidenceGraph::Nodes neighbours = HB[*v];
-                    for (typename IncidenceGraph::Nodes::iterator neighbour = neighbours.begin(); neighbour != neighbours.end(); neighbour++)
+                    if (GetBorderVertexOwner(*v)->second > 1)
                     {
-                        if (!(*node)->HasNeighbour(*neighbour))
-                        {
-                            typename IncidenceGraph::Edge *edge = new typename IncidenceGraph::Edge(*node, *neighbour);
-                            incidenceGraph->edges.push_back(edge);
-                            (*node)->AddEdge(edge);
-                            (*neighbour)->AddEdge(edge);
-                        }
+                        mergedNodes[i]->borderVerts.insert(mergedNodes[i]->borderVerts.end(), *v);
                     }
                 }
             }
-        }
+
+            // merged packs are computed independently, like in the first level
+            CalculateIncidenceGraphs(mergedNodes);
+
+            // merged pack takes place of its first part, so order
+            // of packs is kept
+            std::vector<int> newIndices(packsCount);
+            Nodes newNodes;
+            int pairIndex = 0;
+            for (int i = 0; i < packsCount; i++)
+            {
+                if (partners[i] == -1)
+                {
+                    newIndices[i] = newNodes.size();
+                    newNodes.push_back(nodes[i]);
+                }
+                else if (partners[i] > i)
+                {
+                    newIndices[i] = newIndices[partners[i]] = newNodes.size();
+                    newNodes.push_back(mergedNodes[pairIndex++]);
+                }
+            }
+            std::vector<std::pair<int, int> > connections;
+            for (typename Edges::iterator edge = edges.begin(); edge != edges.end(); edge++)
+            {
+                int a = newIndices[packsIndices[(*edge)->nodeA]];
+                int b = newIndices[packsIndices[(*edge)->nodeB]];
+                if (a != b)
+                {
+                    connections.push_back(std::pair<int, int>(std::min(a, b), std::max(a, b)));
+                }
+                delete (*edge);
+            }
+            edges.clear();
+            for (int i = 0; i < packsCount; i++)
+            {
+                if (partners[i] != -1)
+                {
+                    delete nodes[i];
+                }
+            }
+            nodes.swap(newNodes);
+            for (typename Nodes::iterator i = nodes.begin(); i != nodes.end(); i++)
+            {
+                (*i)->edges.clear();
+            }
+            std::sort(connections.begin(), connections.end());
+            connections.erase(std::unique(connections.begin(), connections.end()), connections.end());
+            for (typename std::vector<std::pair<int, int> >::iterator c = connections.begin(); c != connections.end(); c++)
+            {
+                Edge *edge = new Edge(nodes[c->first], nodes[c->second]);
+                edges.push_back(edge);
+                nodes[c->first]->AddEdge(edge);
+                nodes[c->second]->AddEdge(edge);
+            }
 
 #ifdef ACCSUB_TRACE
-        Timer::Update("connecting simplices on border");
+            std::cout<<"merge tree level "<<level<<": packs: "<<nodes.size()<<" border vertices: "<<GetBorderVertsCount()<<std::endl;
+            Timer::Update("merging packs");
+            MemoryInfo::Print();
 #endif
+        }
+        std::vector<VertexOwner>().swap(borderVertsOwners);
+    }
 
-        // moving all nodes and edges to a single incidence graph
-        for (typename Nodes::iterator i = nodes.begin(); i != nodes.end(); i++)
+    typename std::vector<VertexOwner>::iterator GetBorderVertexOwner(const Vertex &v)
+    {
+        typename std::vector<VertexOwner>::iterator owner = std::lower_bound(borderVertsOwners.begin(), borderVertsOwners.end(), VertexOwner(v, 0));
+        assert(owner != borderVertsOwners.end() && owner->first == v);
+        return owner;
+    }
+
+    // border simplices from different packs sharing a vertex are connected,
+    // nodes of i-th pack are stored in ig->nodes[nodesOffsets[i]..nodesOffsets[i + 1])
+    void ConnectBorderNodes(IncidenceGraph *ig, const std::vector<int> &nodesOffsets, int packsCount)
+    {
+        // index of border simplices vertices sorted by vertices
+        std::vector<int> entriesOffsets(packsCount + 1, 0);
+#ifdef USE_OMP
+        #pragma omp parallel for schedule(dynamic)
+#endif
+        for (int i = 0; i < packsCount; i++)
         {
-            incidenceGraph->nodes.insert(incidenceGraph->nodes.end(), (*i)->ig->nodes.begin(), (*i)->ig->nodes.end());
-            (*i)->ig->nodes.clear();
-            incidenceGraph->edges.insert(incidenceGraph->edges.end(), (*i)->ig->edges.begin(), (*i)->ig->edges.end());
-            (*i)->ig->edges.clear();
+            int count = 0;
+            for (int n = nodesOffsets[i]; n < nodesOffsets[i + 1]; n++)
+            {
+                typename IncidenceGraph::Node *node = ig->nodes[n];
+                if (node->IsOnBorder())
+                {
+                    count += node->simplex->size();
+                }
+            }
+            entriesOffsets[i + 1] = count;
         }
-
-        for (typename Nodes::iterator i = isolatedNodes.begin(); i != isolatedNodes.end(); i++)
+        for (int i = 0; i < packsCount; i++)
         {
-            incidenceGraph->nodes.insert(incidenceGraph->nodes.end(), (*i)->ig->nodes.begin(), (*i)->ig->nodes.end());
-            (*i)->ig->nodes.clear();
-            incidenceGraph->edges.insert(incidenceGraph->edges.end(), (*i)->ig->edges.begin(), (*i)->ig->edges.end());
-            (*i)->ig->edges.clear();
+            entriesOffsets[i + 1] += entriesOffsets[i];
         }
-
-        for (typename IncidenceGraph::Nodes::iterator i = incidenceGraph->nodes.begin(); i != incidenceGraph->nodes.end(); i++)
+        std::vector<BorderEntry> entries(entriesOffsets[packsCount]);
+#ifdef USE_OMP
+        #pragma omp parallel for schedule(dynamic)
+#endif
+        for (int i = 0; i < packsCount; i++)
         {
-            (*i)->SetParentGraph(incidenceGraph);
+            int index = entriesOffsets[i];
+            for (int n = nodesOffsets[i]; n < nodesOffsets[i + 1]; n++)
+            {
+                typename IncidenceGraph::Node *node = ig->nodes[n];
+                if (!node->IsOnBorder())
+                {
+                    continue;
+                }
+                for (typename Simplex::iterator v = node->simplex->begin(); v != node->simplex->end(); v++)
+                {
+                    entries[index++] = BorderEntry(*v, i, n);
+                }
+            }
         }
+        std::sort(entries.begin(), entries.end());
 
-#ifdef ACCSUB_TRACE
-        std::cout<<"total simplices after connecting graphs: "<<incidenceGraph->nodes.size()<<std::endl;
-        std::cout<<"reduced acyclic subset size: "<<(initialSize - incidenceGraph->nodes.size())<<" ("<<((initialSize - incidenceGraph->nodes.size()) * 100 / initialSize)<<"%)"<<std::endl;
-        Timer::Update("moving simplices to single incidence graph");
+        // buckets of entries with the same vertex
+        std::vector<int> buckets;
+        int entriesCount = entries.size();
+        for (int i = 0; i < entriesCount; i++)
+        {
+            if (i == 0 || entries[i].vertex != entries[i - 1].vertex)
+            {
+                buckets.push_back(i);
+            }
+        }
+        buckets.push_back(entriesCount);
+        int bucketsCount = buckets.size() - 1;
+
+        // simplices from different packs sharing a vertex are connected,
+        // pairs found in many buckets are removed by sorting
+        std::vector<NodesPair> pairs;
+#ifdef USE_OMP
+        #pragma omp parallel
+#endif
+        {
+            std::vector<NodesPair> threadPairs;
+#ifdef USE_OMP
+            #pragma omp for schedule(dynamic, 64)
+#endif
+            for (int b = 0; b < bucketsCount; b++)
+            {
+                int end = buckets[b + 1];
+                for (int i = buckets[b]; i < end; i++)
+                {
+                    int j = i + 1;
+                    while (j < end && entries[j].pack == entries[i].pack)
+                    {
+                        j++;
+                    }
+                    for (; j < end; j++)
+                    {
+                        threadPairs.push_back(NodesPair(entries[i].node, entries[j].node));
+                    }
+                }
+            }
+#ifdef USE_OMP
+            #pragma omp critical
+#endif
+            pairs.insert(pairs.end(), threadPairs.begin(), threadPairs.end());
+        }
+        std::vector<BorderEntry>().swap(entries);
+        std::sort(pairs.begin(), pairs.end());
+        pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+        int pairsCount = pairs.size();
+        int edgesOffset = ig->edges.size();
+        ig->edges.resize(edgesOffset + pairsCount);
+#ifdef USE_OMP
+        #pragma omp parallel for
 #endif
+        for (int i = 0; i < pairsCount; i++)
+        {
+            ig->edges[edgesOffset + i] = new typename IncidenceGraph::Edge(ig->nodes[pairs[i].first], ig->nodes[pairs[i].second]);
+        }
+        // nodes edges lists are shared between pairs, so they are updated
+        // sequentially
+        for (int i = 0; i < pairsCount; i++)
+        {
+            typename IncidenceGraph::Edge *edge = ig->edges[edgesOffset + i];
+            edge->nodeA->AddEdge(edge);
+            edge->nodeB->AddEdge(edge);
+        }
     }
 };
 
+template <typename IncidenceGraphType, template <typename> class PrepareDataPolicy, template <typename> class ComputationsPolicy>
+float PartitionGraphT<IncidenceGraphType, PrepareDataPolicy, ComputationsPolicy>::packSplitFactor = 0;
+
+template <typename IncidenceGraphType, template <typename> class PrepareDataPolicy, template <typename> class ComputationsPolicy>
+int PartitionGraphT<IncidenceGraphType, PrepareDataPolicy, ComputationsPolicy>::mergeTreeLevels = 0;
+
 #endif /* PARTITIONGRAPH_HPP */
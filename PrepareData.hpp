@@ -14,6 +14,7 @@
 
 #include <cstdlib>
 #include <cstring> // memset
+#include <algorithm> // sort
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -150,5 +151,494 @@ public:
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// partitions simplices into packs with multilevel algorithm (coarsening,
+// initial partitioning and refinement) minimizing number of vertices shared
+// by different packs. simplices are treated as nodes of hypergraph
+// and vertices as its nets. packs are exactly packSize long (except the
+// last one), so DivideData can slice reordered list as before
+template <typename PartitionGraph>
+class PrepareDataMultilevel
+{
+    typedef typename PartitionGraph::Vertex Vertex;
+    typedef typename PartitionGraph::Simplex Simplex;
+    typedef typename PartitionGraph::SimplexList SimplexList;
+
+    struct Hypergraph
+    {
+        std::vector<int> nodesWeights;
+        std::vector<int> nodesNetsStart;
+        std::vector<int> nodesNets;
+        std::vector<int> netsPinsStart;
+        std::vector<int> netsPins;
+
+        int NodesCount() const { return nodesWeights.size(); }
+        int NetsCount() const { return netsPinsStart.size() - 1; }
+
+        void CreateNodesNets()
+        {
+            int nodesCount = NodesCount();
+            nodesNetsStart.assign(nodesCount + 1, 0);
+            for (typename std::vector<int>::iterator pin = netsPins.begin(); pin != netsPins.end(); pin++)
+            {
+                nodesNetsStart[*pin + 1]++;
+            }
+            for (int i = 0; i < nodesCount; i++)
+            {
+                nodesNetsStart[i + 1] += nodesNetsStart[i];
+            }
+            nodesNets.resize(netsPins.size());
+            std::vector<int> position(nodesNetsStart.begin(), nodesNetsStart.end() - 1);
+            int netsCount = NetsCount();
+            for (int net = 0; net < netsCount; net++)
+            {
+                for (int i = netsPinsStart[net]; i < netsPinsStart[net + 1]; i++)
+                {
+                    nodesNets[position[netsPins[i]]++] = net;
+                }
+            }
+        }
+    };
+
+    // nets larger than this are ignored while matching and computing gains
+    // (e.g. apex of a cone), they are cut by almost every partition anyway
+    static const int MAX_NET_SIZE = 256;
+    // coarsening stops when there are at most that many nodes per pack
+    static const int COARSEST_NODES_PER_PART = 32;
+    static const int REFINEMENT_PASSES = 8;
+
+public:
+
+    static void Prepare(SimplexList &simplexList, int packSize)
+    {
+        int count = simplexList.size();
+        if (packSize < 1 || count <= packSize)
+        {
+            return;
+        }
+        int partsCount = (count + packSize - 1) / packSize;
+
+        std::vector<Hypergraph *> levels;
+        std::vector<std::vector<int> > maps;
+        Hypergraph *hg = new Hypergraph();
+        CreateHypergraph(simplexList, *hg);
+        levels.push_back(hg);
+
+        int maxNodeWeight = std::max(1, packSize / 16);
+        while (hg->NodesCount() > partsCount * COARSEST_NODES_PER_PART)
+        {
+            Hypergraph *coarse = new Hypergraph();
+            maps.push_back(std::vector<int>());
+            Coarsen(*hg, *coarse, maps.back(), maxNodeWeight);
+            // matching does not reduce graph significantly any more
+            if (coarse->NodesCount() * 10 > hg->NodesCount() * 9)
+            {
+                delete coarse;
+                maps.pop_back();
+                break;
+            }
+            levels.push_back(coarse);
+            hg = coarse;
+        }
+
+        std::vector<int> capacities(partsCount, packSize);
+        capacities[partsCount - 1] = count - packSize * (partsCount - 1);
+        std::vector<int> maxWeights(partsCount);
+        for (int i = 0; i < partsCount; i++)
+        {
+            maxWeights[i] = capacities[i] + std::max(1, capacities[i] / 20);
+        }
+
+        std::vector<int> parts;
+        InitialPartition(*hg, partsCount, packSize, parts);
+        Refine(*hg, parts, partsCount, maxWeights);
+        for (int level = levels.size() - 2; level >= 0; level--)
+        {
+            std::vector<int> &map = maps[level];
+            std::vector<int> fineParts(map.size());
+            for (int i = 0; i < (int)map.size(); i++)
+            {
+                fineParts[i] = parts[map[i]];
+            }
+            parts.swap(fineParts);
+            delete levels[level + 1];
+            Refine(*levels[level], parts, partsCount, maxWeights);
+        }
+        Rebalance(*levels[0], parts, partsCount, capacities);
+        delete levels[0];
+
+        // stable counting sort of simplices by parts
+        std::vector<int> position(partsCount + 1, 0);
+        for (int i = 0; i < count; i++)
+        {
+            position[parts[i] + 1]++;
+        }
+        for (int i = 0; i < partsCount; i++)
+        {
+            position[i + 1] += position[i];
+        }
+        SimplexList sorted(count);
+        for (int i = 0; i < count; i++)
+        {
+            sorted[position[parts[i]]++].swap(simplexList[i]);
+        }
+        simplexList.swap(sorted);
+    }
+
+private:
+
+    static void CreateHypergraph(SimplexList &simplexList, Hypergraph &hg)
+    {
+        int count = simplexList.size();
+        std::map<Vertex, std::vector<int> > H;
+        for (int i = 0; i < count; i++)
+        {
+            Simplex &s = simplexList[i];
+            for (typename Simplex::iterator v = s.begin(); v != s.end(); v++)
+            {
+                H[*v].push_back(i);
+            }
+        }
+        hg.nodesWeights.assign(count, 1);
+        hg.netsPinsStart.push_back(0);
+        for (typename std::map<Vertex, std::vector<int> >::iterator net = H.begin(); net != H.end(); net++)
+        {
+            // vertices belonging to single simplex are never on border
+            if (net->second.size() < 2)
+            {
+                continue;
+            }
+            hg.netsPins.insert(hg.netsPins.end(), net->second.begin(), net->second.end());
+            hg.netsPinsStart.push_back(hg.netsPins.size());
+        }
+        hg.CreateNodesNets();
+    }
+
+    // heavy connectivity matching: each node is merged with its unmatched
+    // neighbour sharing the most (small) nets
+    static void Coarsen(const Hypergraph &fine, Hypergraph &coarse, std::vector<int> &map, int maxNodeWeight)
+    {
+        int nodesCount = fine.NodesCount();
+        map.assign(nodesCount, -1);
+        std::vector<float> scores(nodesCount, 0.0f);
+        std::vector<int> touched;
+        int coarseCount = 0;
+        for (int u = 0; u < nodesCount; u++)
+        {
+            if (map[u] != -1)
+            {
+                continue;
+            }
+            int weight = fine.nodesWeights[u];
+            for (int i = fine.nodesNetsStart[u]; i < fine.nodesNetsStart[u + 1]; i++)
+            {
+                int net = fine.nodesNets[i];
+                int size = fine.netsPinsStart[net + 1] - fine.netsPinsStart[net];
+                if (size > MAX_NET_SIZE)
+                {
+                    continue;
+                }
+                float score = 1.0f / (size - 1);
+                for (int j = fine.netsPinsStart[net]; j < fine.netsPinsStart[net + 1]; j++)
+                {
+                    int v = fine.netsPins[j];
+                    if (v == u || map[v] != -1 || weight + fine.nodesWeights[v] > maxNodeWeight)
+                    {
+                        continue;
+                    }
+                    if (scores[v] == 0.0f)
+                    {
+                        touched.push_back(v);
+                    }
+                    scores[v] += score;
+                }
+            }
+            int best = -1;
+            float bestScore = 0.0f;
+            for (typename std::vector<int>::iterator v = touched.begin(); v != touched.end(); v++)
+            {
+                if (scores[*v] > bestScore)
+                {
+                    bestScore = scores[*v];
+                    best = *v;
+                }
+                scores[*v] = 0.0f;
+            }
+            touched.clear();
+            map[u] = coarseCount;
+            if (best != -1)
+            {
+                map[best] = coarseCount;
+                weight += fine.nodesWeights[best];
+            }
+            coarse.nodesWeights.push_back(weight);
+            coarseCount++;
+        }
+
+        std::vector<int> marker(coarseCount, -1);
+        coarse.netsPinsStart.push_back(0);
+        int netsCount = fine.NetsCount();
+        for (int net = 0; net < netsCount; net++)
+        {
+            int start = coarse.netsPins.size();
+            for (int i = fine.netsPinsStart[net]; i < fine.netsPinsStart[net + 1]; i++)
+            {
+                int c = map[fine.netsPins[i]];
+                if (marker[c] != net)
+                {
+                    marker[c] = net;
+                    coarse.netsPins.push_back(c);
+                }
+            }
+            if ((int)coarse.netsPins.size() - start < 2)
+            {
+                coarse.netsPins.resize(start);
+                continue;
+            }
+            coarse.netsPinsStart.push_back(coarse.netsPins.size());
+        }
+        coarse.CreateNodesNets();
+    }
+
+    // nodes are visited in BFS order and assigned to consecutive parts
+    // according to accumulated weight (like PrepareDataBFS on coarse graph)
+    static void InitialPartition(const Hypergraph &hg, int partsCount, int packSize, std::vector<int> &parts)
+    {
+        int nodesCount = hg.NodesCount();
+        parts.assign(nodesCount, -1);
+        std::vector<char> added(nodesCount, 0);
+        std::vector<int> queue;
+        queue.reserve(nodesCount);
+        int totalWeight = 0;
+        for (int i = 0; i < nodesCount; i++)
+        {
+            if (added[i])
+            {
+                continue;
+            }
+            added[i] = 1;
+            queue.push_back(i);
+            for (int head = queue.size() - 1; head < (int)queue.size(); head++)
+            {
+                int u = queue[head];
+                int weight = hg.nodesWeights[u];
+                parts[u] = std::min(partsCount - 1, (totalWeight + weight / 2) / packSize);
+                totalWeight += weight;
+                for (int j = hg.nodesNetsStart[u]; j < hg.nodesNetsStart[u + 1]; j++)
+                {
+                    int net = hg.nodesNets[j];
+                    for (int k = hg.netsPinsStart[net]; k < hg.netsPinsStart[net + 1]; k++)
+                    {
+                        int v = hg.netsPins[k];
+                        if (!added[v])
+                        {
+                            added[v] = 1;
+                            queue.push_back(v);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    // computes for node u: number of nets in which u is the only pin of its
+    // part (base) and number of nets connecting u with other parts
+    // (connections). moving u to part p changes number of
+    // (net, part) pairs by base - (degree - connections[p])
+    struct GainsCalculator
+    {
+        const Hypergraph &hg;
+        const std::vector<int> &parts;
+        std::vector<int> connections;
+        std::vector<int> netMarker;
+        std::vector<int> candidates;
+        int base;
+        int degree;
+        int stamp;
+
+        GainsCalculator(const Hypergraph &hg, const std::vector<int> &parts, int partsCount) : hg(hg), parts(parts)
+        {
+            connections.assign(partsCount, 0);
+            netMarker.assign(partsCount, -1);
+            stamp = 0;
+        }
+
+        void Calculate(int u)
+        {
+            for (typename std::vector<int>::iterator p = candidates.begin(); p != candidates.end(); p++)
+            {
+                connections[*p] = 0;
+            }
+            candidates.clear();
+            base = 0;
+            degree = 0;
+            int part = parts[u];
+            for (int i = hg.nodesNetsStart[u]; i < hg.nodesNetsStart[u + 1]; i++)
+            {
+                int net = hg.nodesNets[i];
+                if (hg.netsPinsStart[net + 1] - hg.netsPinsStart[net] > MAX_NET_SIZE)
+                {
+                    continue;
+                }
+                degree++;
+                stamp++;
+                int samePart = 0;
+                for (int j = hg.netsPinsStart[net]; j < hg.netsPinsStart[net + 1]; j++)
+                {
+                    int v = hg.netsPins[j];
+                    if (v == u)
+                    {
+                        continue;
+                    }
+                    int p = parts[v];
+                    if (p == part)
+                    {
+                        samePart++;
+                    }
+                    else if (netMarker[p] != stamp)
+                    {
+                        netMarker[p] = stamp;
+                        if (connections[p] == 0)
+                        {
+                            candidates.push_back(p);
+                        }
+                        connections[p]++;
+                    }
+                }
+                if (samePart == 0)
+                {
+                    base++;
+                }
+            }
+        }
+
+        int Gain(int p) const
+        {
+            return base - (degree - connections[p]);
+        }
+    };
+
+    // greedy k-way refinement of border nodes with balance constraint
+    static void Refine(const Hypergraph &hg, std::vector<int> &parts, int partsCount, const std::vector<int> &maxWeights)
+    {
+        int nodesCount = hg.NodesCount();
+        std::vector<int> partsWeights(partsCount, 0);
+        for (int i = 0; i < nodesCount; i++)
+        {
+            partsWeights[parts[i]] += hg.nodesWeights[i];
+        }
+        GainsCalculator gains(hg, parts, partsCount);
+        for (int pass = 0; pass < REFINEMENT_PASSES; pass++)
+        {
+            int moved = 0;
+            for (int u = 0; u < nodesCount; u++)
+            {
+                gains.Calculate(u);
+                int part = parts[u];
+                int weight = hg.nodesWeights[u];
+                int best = -1;
+                int bestGain = 0;
+                for (typename std::vector<int>::iterator p = gains.candidates.begin(); p != gains.candidates.end(); p++)
+                {
+                    if (partsWeights[*p] + weight > maxWeights[*p])
+                    {
+                        continue;
+                    }
+                    int gain = gains.Gain(*p);
+                    // moves without gain are accepted only if they improve balance
+                    if (gain > bestGain || (gain == 0 && best == -1 && partsWeights[*p] + weight < partsWeights[part]))
+                    {
+                        best = *p;
+                        bestGain = gain;
+                    }
+                }
+                if (best != -1)
+                {
+                    parts[u] = best;
+                    partsWeights[part] -= weight;
+                    partsWeights[best] += weight;
+                    moved++;
+                }
+            }
+            if (moved == 0)
+            {
+                break;
+            }
+        }
+    }
+
+    struct Move
+    {
+        int gain;
+        int node;
+        int part;
+
+        Move(int gain, int node, int part) : gain(gain), node(node), part(part) { }
+
+        bool operator<(const Move &m) const
+        {
+            return (gain > m.gain || (gain == m.gain && node < m.node));
+        }
+    };
+
+    // moves nodes (all with unit weight) from overloaded parts so that
+    // every part has exactly its capacity
+    static void Rebalance(const Hypergraph &hg, std::vector<int> &parts, int partsCount, const std::vector<int> &capacities)
+    {
+        int nodesCount = hg.NodesCount();
+        std::vector<int> partsWeights(partsCount, 0);
+        for (int i = 0; i < nodesCount; i++)
+        {
+            partsWeights[parts[i]]++;
+        }
+        std::vector<Move> moves;
+        GainsCalculator gains(hg, parts, partsCount);
+        for (int u = 0; u < nodesCount; u++)
+        {
+            int part = parts[u];
+            if (partsWeights[part] <= capacities[part])
+            {
+                continue;
+            }
+            gains.Calculate(u);
+            // -1 means any underloaded part
+            int best = -1;
+            int bestGain = gains.base - gains.degree;
+            for (typename std::vector<int>::iterator p = gains.candidates.begin(); p != gains.candidates.end(); p++)
+            {
+                if (partsWeights[*p] < capacities[*p] && gains.Gain(*p) >= bestGain)
+                {
+                    best = *p;
+                    bestGain = gains.Gain(*p);
+                }
+            }
+            moves.push_back(Move(bestGain, u, best));
+        }
+        std::sort(moves.begin(), moves.end());
+        int underloaded = 0;
+        for (typename std::vector<Move>::iterator move = moves.begin(); move != moves.end(); move++)
+        {
+            int part = parts[move->node];
+            if (partsWeights[part] <= capacities[part])
+            {
+                continue;
+            }
+            int target = move->part;
+            if (target == -1 || partsWeights[target] >= capacities[target])
+            {
+                while (partsWeights[underloaded] >= capacities[underloaded])
+                {
+                    underloaded++;
+                }
+                target = underloaded;
+            }
+            parts[move->node] = target;
+            partsWeights[part]--;
+            partsWeights[target]++;
+        }
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////
+
 #endif	/* PREPAREDATA_HPP */
 
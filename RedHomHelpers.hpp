@@ -185,6 +185,8 @@ private:
         }
     }
 
+public:
+
     static void PrintBettiNumbers(const Betti& betti)
     {
         if (betti.size() == 0)
@@ -0,0 +1,253 @@
+/*
+ * File:   SimplexListBinary.hpp
+ * Author: Piotr Brendel
+ *         piotr.brendel@ii.uj.edu.pl
+ *
+ *         AccSub - constructing and removing acyclic subset
+ *                  for simplicial complexes
+ *         This code is a part of RedHom library
+ *         http://redhom.ii.uj.edu.pl
+ */
+
+#ifndef SIMPLEXLISTBINARY_HPP
+#define	SIMPLEXLISTBINARY_HPP
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <utility>
+
+#ifdef LINUX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+// kept apart from SimplexUtils, which includes external/rips.hpp (not
+// suitable for inclusion in more than one translation unit)
+template <typename Simplex>
+class SimplexListBinary
+{
+    typedef std::vector<Simplex> SimplexList;
+
+public:
+
+    // binary file contains number of simplices, offsets of simplices
+    // (number of simplices + 1 values) and vertices, all stored as ints.
+    // simplices can be read by indices without parsing whole file
+    static void Write(const SimplexList &simplexList, const char *filename)
+    {
+        std::ofstream output(filename, std::ios::out | std::ios::binary);
+        if (!output.is_open())
+        {
+            throw std::string("Can't create file ") + filename;
+        }
+
+        int count = simplexList.size();
+        std::vector<int> offsets;
+        offsets.reserve(count + 1);
+        offsets.push_back(0);
+        for (typename SimplexList::const_iterator s = simplexList.begin(); s != simplexList.end(); s++)
+        {
+            offsets.push_back(offsets.back() + s->size());
+        }
+        output.write((const char *)&count, sizeof(int));
+        output.write((const char *)&offsets[0], sizeof(int) * (count + 1));
+        std::vector<int> verts;
+        for (typename SimplexList::const_iterator s = simplexList.begin(); s != simplexList.end(); s++)
+        {
+            verts.assign(s->begin(), s->end());
+            if (verts.size() > 0)
+            {
+                output.write((const char *)&verts[0], sizeof(int) * verts.size());
+            }
+        }
+        output.close();
+    }
+
+    // dimension of the first simplex (like Simplex::GetSimplexListDimension),
+    // only the first two offsets are read
+    static int GetDimension(const char *filename)
+    {
+        std::ifstream input(filename, std::ios::in | std::ios::binary);
+        if (!input.is_open())
+        {
+            throw std::string("Can't open file ") + filename;
+        }
+        int header[3] = { 0, 0, 1 };
+        input.read((char *)header, sizeof(int) * 3);
+        if (!input && header[0] > 0)
+        {
+            throw std::string("Can't read file ") + filename;
+        }
+        input.close();
+        return (header[0] > 0) ? (header[2] - header[1] - 1) : 0;
+    }
+
+    // simplices are read part by part in order of the file. offsets and
+    // vertices are read by separate streams, so the file is read once
+    class Reader
+    {
+        std::string     filename;
+        std::ifstream   offsetsInput;
+        std::ifstream   vertsInput;
+        int             count;
+        int             current;
+        int             currentOffset;
+        std::vector<int> offsets;
+        std::vector<int> verts;
+
+    public:
+
+        Reader(const char *filename) : filename(filename)
+        {
+            offsetsInput.open(filename, std::ios::in | std::ios::binary);
+            vertsInput.open(filename, std::ios::in | std::ios::binary);
+            if (!offsetsInput.is_open() || !vertsInput.is_open())
+            {
+                throw std::string("Can't open file ") + filename;
+            }
+            count = 0;
+            offsetsInput.read((char *)&count, sizeof(int));
+            offsetsInput.read((char *)&currentOffset, sizeof(int));
+            vertsInput.seekg(std::streamoff(sizeof(int)) * (count + 2));
+            current = 0;
+        }
+
+        int GetCount() const { return count; }
+
+        // index of the first simplex returned by next call of ReadNext
+        int GetCurrent() const { return current; }
+
+        // at most maxCount next simplices replace content of simplexList,
+        // returns false if there are no simplices left
+        bool ReadNext(SimplexList &simplexList, int maxCount)
+        {
+            int readCount = (count - current < maxCount) ? (count - current) : maxCount;
+            if (readCount <= 0)
+            {
+                return false;
+            }
+            offsets.resize(readCount);
+            offsetsInput.read((char *)&offsets[0], sizeof(int) * readCount);
+            verts.resize(offsets.back() - currentOffset);
+            if (verts.size() > 0)
+            {
+                vertsInput.read((char *)&verts[0], sizeof(int) * verts.size());
+            }
+            if (!offsetsInput || !vertsInput)
+            {
+                throw std::string("Can't read file ") + filename;
+            }
+            simplexList.resize(readCount);
+            int first = currentOffset;
+            for (int i = 0; i < readCount; i++)
+            {
+                simplexList[i].assign(verts.begin() + (currentOffset - first), verts.begin() + (offsets[i] - first));
+                currentOffset = offsets[i];
+            }
+            current += readCount;
+            return true;
+        }
+    };
+
+    // ranges are pairs (index of first simplex, number of simplices),
+    // read simplices are appended to simplexList
+    static void Read(SimplexList &simplexList, const char *filename, const std::vector<std::pair<int, int> > &ranges)
+    {
+        int total = simplexList.size();
+        for (std::vector<std::pair<int, int> >::const_iterator r = ranges.begin(); r != ranges.end(); r++)
+        {
+            total += r->second;
+        }
+        simplexList.reserve(total);
+#ifdef LINUX
+        // file is mapped, so only pages with given ranges are read
+        int fd = open(filename, O_RDONLY);
+        if (fd == -1)
+        {
+            throw std::string("Can't open file ") + filename;
+        }
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) != 0 || fileStat.st_size < (off_t)sizeof(int))
+        {
+            close(fd);
+            throw std::string("Can't read file ") + filename;
+        }
+        size_t fileSize = fileStat.st_size;
+        void *address = mmap(0, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (address == MAP_FAILED)
+        {
+            throw std::string("Can't map file ") + filename;
+        }
+        const int *data = (const int *)address;
+        size_t intsCount = fileSize / sizeof(int);
+        int count = data[0];
+        const int *offsets = data + 1;
+        const int *verts = data + count + 2;
+        for (std::vector<std::pair<int, int> >::const_iterator r = ranges.begin(); r != ranges.end(); r++)
+        {
+            if (r->first < 0 || r->second < 0 || r->first + r->second > count || (size_t)count + 2 > intsCount ||
+                (size_t)count + 2 + offsets[r->first + r->second] > intsCount)
+            {
+                munmap(address, fileSize);
+                throw std::string("Invalid simplices range in file ") + filename;
+            }
+            int first = simplexList.size();
+            simplexList.resize(first + r->second);
+            for (int i = 0; i < r->second; i++)
+            {
+                simplexList[first + i].assign(verts + offsets[r->first + i], verts + offsets[r->first + i + 1]);
+            }
+        }
+        munmap(address, fileSize);
+#else
+        std::ifstream input(filename, std::ios::in | std::ios::binary);
+        if (!input.is_open())
+        {
+            throw std::string("Can't open file ") + filename;
+        }
+
+        int count = 0;
+        input.read((char *)&count, sizeof(int));
+        std::streamoff vertsStart = sizeof(int) * (count + 2);
+        std::vector<int> offsets;
+        std::vector<int> verts;
+        for (std::vector<std::pair<int, int> >::const_iterator r = ranges.begin(); r != ranges.end(); r++)
+        {
+            if (r->first < 0 || r->second < 0 || r->first + r->second > count)
+            {
+                throw std::string("Invalid simplices range in file ") + filename;
+            }
+            if (r->second == 0)
+            {
+                continue;
+            }
+            offsets.resize(r->second + 1);
+            input.seekg(sizeof(int) * (r->first + 1));
+            input.read((char *)&offsets[0], sizeof(int) * (r->second + 1));
+            verts.resize(offsets.back() - offsets.front());
+            input.seekg(vertsStart + std::streamoff(sizeof(int)) * offsets.front());
+            if (verts.size() > 0)
+            {
+                input.read((char *)&verts[0], sizeof(int) * verts.size());
+            }
+            if (!input)
+            {
+                throw std::string("Can't read file ") + filename;
+            }
+            int first = simplexList.size();
+            simplexList.resize(first + r->second);
+            for (int i = 0; i < r->second; i++)
+            {
+                simplexList[first + i].assign(verts.begin() + (offsets[i] - offsets.front()), verts.begin() + (offsets[i + 1] - offsets.front()));
+            }
+        }
+        input.close();
+#endif
+    }
+};
+
+#endif	/* SIMPLEXLISTBINARY_HPP */
@@ -160,37 +160,53 @@ public:
         return totalSimplices;
     }
 
+    // neighbours are searched with spatial index (rips::epsilonGraph), so
+    // big point clouds are not compared pair by pair
     static bool GenerateRandomRipsComplex(SimplexList &simplexList, int pointsCount, float pointsDiam, int pointsDim, float ripsComplexEpsilon, float ripsComplexDim)
     {
-        typedef rips::euclidanPoint EuclideanPoint;
-        typedef rips::simplicialComplex<EuclideanPoint> RipsComplex;
-
         srand(time(0));
         float radius = pointsDiam * 0.5f;
-        std::vector<EuclideanPoint> points;
+        std::vector<float> coords;
+        coords.reserve(pointsCount * pointsDim);
         for (int i = 0; i < pointsCount; i++)
         {
-            std::vector<double> coords;
             for (int j = 0; j < pointsDim; j++)
             {
                 float c = ((rand() % RAND_MAX) * pointsDiam - radius) / RAND_MAX;
                 coords.push_back(c);
             }
-            points.push_back(EuclideanPoint(coords));
         }
-        RipsComplex complex(points, ripsComplexEpsilon, ripsComplexDim);
-        std::vector<std::set<int> > tempSimplexList;
-        complex.outputMaxSimplices(tempSimplexList);
-        for (std::vector<std::set<int> >::iterator i = tempSimplexList.begin(); i != tempSimplexList.end(); i++)
+        rips::epsilonGraph graph(coords, pointsDim, ripsComplexEpsilon);
+        std::vector<std::vector<int> > tempSimplexList;
+        graph.outputMaxSimplices((int)ripsComplexDim, tempSimplexList);
+        int first = simplexList.size();
+        simplexList.resize(first + tempSimplexList.size());
+        for (int i = 0; i < (int)tempSimplexList.size(); i++)
         {
-            Simplex s;
-            for (std::set<int>::iterator j = i->begin(); j != i->end(); j++)
+            simplexList[first + i].assign(tempSimplexList[i].begin(), tempSimplexList[i].end());
+        }
+        std::sort(simplexList.begin(), simplexList.end(), Simplex::SortBySizeDesc);
+        return true;
+    }
+
+    // ring of simplices wrapped around, its homology is the homology of
+    // circle. simplices have sorted vertices (last ones wrap to 0)
+    static void GenerateBand(SimplexList &simplexList, int simplicesCount, int dim)
+    {
+        if (dim < 1 || simplicesCount < 2 * (dim + 1))
+        {
+            throw std::string("SimplexUtils: band needs at least 2 * (dim + 1) simplices");
+        }
+        for (int i = 0; i < simplicesCount; i++)
+        {
+            Simplex simplex;
+            for (int j = 0; j <= dim; j++)
             {
-                s.push_back(*j);
+                simplex.push_back((i + j) % simplicesCount);
             }
-            simplexList.push_back(s);
+            std::sort(simplex.begin(), simplex.end());
+            simplexList.push_back(simplex);
         }
-        std::sort(simplexList.begin(), simplexList.end(), Simplex::SortBySizeDesc);
     }
 
     static bool FindDuplicates(SimplexList &simplexList)
@@ -11,9 +11,11 @@
 
 #include "Tests.h"
 #include "RedHomHelpers.hpp"
+#include "HomologyZ2.hpp"
 #include "Utils.hpp"
 #include "SimplexUtils.hpp"
 #include "IncidenceGraphHelpers.hpp"
+#include "SimplexListBinary.hpp"
 
 #include <cassert>
 
@@ -37,6 +39,24 @@ float Tests::randomPointsDiam = 1;
 int Tests::randomPointsDim = 4;
 float Tests::ripsComplexEpsilon = 0.05f;
 int Tests::ripsComplexDim = 4;
+int Tests::benchmarkIterations = 10000000;
+int Tests::bandSimplicesCount = 40;
+int Tests::bandDim = 3;
+int Tests::stressRepeats = 0;
+int Tests::stressPacksCount = 64;
+int Tests::partitionPacksCount = 0;
+float Tests::packSplitFactor = 0;
+int Tests::mergeTreeLevels = 0;
+std::string Tests::localInputFilename = "";
+int Tests::localInputDim = 0;
+std::string Tests::writeLocalInputFilename = "";
+int Tests::distributedJoin = 0;
+int Tests::shmWorkersCount = 0;
+int Tests::singleSearchFrontier = 0;
+int Tests::outputRepeats = 0;
+int Tests::homologyEngine = 0;
+int Tests::streamOutput = 0;
+std::string Tests::streamFilename = "";
 
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -54,6 +74,13 @@ void Tests::PrintHelp()
     std::cout<<"                                       - s_dim - dimension of space ["<<randomPointsDim<<"]"<<std::endl;
     std::cout<<"                                       - epsilon - epsilon of complex ["<<ripsComplexEpsilon<<"]"<<std::endl;
     std::cout<<"                                       - c_dim - max dimension of complex ["<<ripsComplexDim<<"]"<<std::endl;
+    std::cout<<"  --band count dim - band of count simplices of dimension dim around a ring,"<<std::endl;
+    std::cout<<"                     simplex i has vertices i..i+dim (mod count) ["<<bandSimplicesCount<<"]["<<bandDim<<"]"<<std::endl;
+    std::cout<<"  --local_input filename - (MPI only) binary file (see --write_local_input) read"<<std::endl;
+    std::cout<<"                           by slaves, packs are its consecutive parts, only"<<std::endl;
+    std::cout<<"                           distributed computations (--use_dist) are run"<<std::endl;
+    std::cout<<"  --bench_flags count - benchmark of intersection flags types on count"<<std::endl;
+    std::cout<<"                        updates of acyclic intersection ["<<benchmarkIterations<<"]"<<std::endl;
     std::cout<<std::endl;
     std::cout<<"options:"<<std::endl;
     std::cout<<"  --use_alg [0|1]      - compute homology without reductions ["<<useAlgebraic<<"]"<<std::endl;
@@ -66,6 +93,27 @@ void Tests::PrintHelp()
     std::cout<<"                              - 0 - AccSub"<<std::endl;
     std::cout<<"                              - 1 - AccSubIG"<<std::endl;
     std::cout<<"                              - 2 - AccSubST"<<std::endl;
+    std::cout<<"  --split_packs f      - split packs with estimated cost greater than f times"<<std::endl;
+    std::cout<<"                         average cost (0 - no splitting) ["<<packSplitFactor<<"]"<<std::endl;
+    std::cout<<"  --merge_tree levels  - merge neighbouring packs pairwise for given number"<<std::endl;
+    std::cout<<"                         of levels before combining graphs ["<<mergeTreeLevels<<"]"<<std::endl;
+    std::cout<<"  --write_local_input filename - write input ordered for packs to binary file"<<std::endl;
+    std::cout<<"                                 for --local_input instead of computations"<<std::endl;
+    std::cout<<"  --dist_join 0|1      - (MPI only) slaves keep their packs and join acyclic"<<std::endl;
+    std::cout<<"                         subsets, only reduced graphs are gathered ["<<distributedJoin<<"]"<<std::endl;
+    std::cout<<"  --shm_workers count  - (SHM only) number of worker processes"<<std::endl;
+    std::cout<<"                         (0 - number of processors) ["<<shmWorkersCount<<"]"<<std::endl;
+    std::cout<<"  --st_frontier 0|1    - AccSubST searches next parts of acyclic subset with one"<<std::endl;
+    std::cout<<"                         breadth first search per component ["<<singleSearchFrontier<<"]"<<std::endl;
+    std::cout<<"  --hom number         - select homology engine ["<<homologyEngine<<"]"<<std::endl;
+    std::cout<<"                          - 0 - RedHom (reference)"<<std::endl;
+    std::cout<<"                          - 1 - Z2 boundary matrices with clearing"<<std::endl;
+    std::cout<<"                          - 2 - Z2 boundary matrices with compression"<<std::endl;
+    std::cout<<"                          - 3 - Z2 boundary matrices, dimensions in parallel"<<std::endl;
+    std::cout<<"  --stream 0|1         - pass output to Z2 homology engine component by component"<<std::endl;
+    std::cout<<"                         freeing processed parts of graph (needs --hom > 0) ["<<streamOutput<<"]"<<std::endl;
+    std::cout<<"  --stream_file filename - with --stream 1 write output cells to file instead"<<std::endl;
+    std::cout<<"                           of computing homology ["<<streamFilename<<"]"<<std::endl;
     std::cout<<"  --test number        - select acyclicity test number ["<<accTestNumber<<"]"<<std::endl;
     std::cout<<"                          - 0 - tabulated configurations (full)"<<std::endl;
     std::cout<<"                          - 1 - CoDim 1 (partial)"<<std::endl;
@@ -73,6 +121,19 @@ void Tests::PrintHelp()
     std::cout<<"                          - 3 - recursive (partial)"<<std::endl;
     std::cout<<"                          - 4 - homology (full)"<<std::endl;
     std::cout<<"                          - 5 - coreductions"<<std::endl;
+    std::cout<<"                          - 6 - tree of configurations"<<std::endl;
+    std::cout<<"                          - 7 - Euler characteristic (partial)"<<std::endl;
+    std::cout<<"                          - 8 - cascade 7129"<<std::endl;
+    std::cout<<"                          - 9 - Z2 homology on flags (full for dim <= 4)"<<std::endl;
+    std::cout<<"                          - number with more digits - cascade of tests"<<std::endl;
+    std::cout<<"                            given by digits, in order of testing"<<std::endl;
+    std::cout<<"  --stress repeats pc  - repeat distributed computations with pc packs and"<<std::endl;
+    std::cout<<"                         one shared acyclicity test, comparing results with"<<std::endl;
+    std::cout<<"                         sequential ones ["<<stressRepeats<<"]["<<stressPacksCount<<"]"<<std::endl;
+    std::cout<<"  --partitions pc      - compare border size and combined graph size of BFS"<<std::endl;
+    std::cout<<"                         and multilevel partitioning into pc packs ["<<partitionPacksCount<<"]"<<std::endl;
+    std::cout<<"  --bench_output repeats - average time of creating output graph from"<<std::endl;
+    std::cout<<"                         AccSubIG graph and from simplex list ["<<outputRepeats<<"]"<<std::endl;
     std::cout<<"  --sv [0|1] - sort vertices before performing computations ["<<sortVerts<<"] "<<std::endl;
     std::cout<<std::endl;
 }
@@ -111,6 +172,19 @@ void Tests::ProcessArgument(std::vector<std::string> &args)
         ripsComplexEpsilon = atof(args[4].c_str());
         ripsComplexDim = atoi(args[5].c_str());
     }
+    else if (arg == "band")
+    {
+        CC("band", 2)
+        inputType = 4;
+        bandSimplicesCount = atoi(args[1].c_str());
+        bandDim = atoi(args[2].c_str());
+    }
+    else if (arg == "bench_flags")
+    {
+        CC("bench_flags", 1)
+        inputType = 3;
+        benchmarkIterations = atoi(args[1].c_str());
+    }
     else if (arg == "use_alg")
     {
         CC("use_alg", 1)
@@ -143,11 +217,82 @@ void Tests::ProcessArgument(std::vector<std::string> &args)
         packsCount = atoi(args[2].c_str());
         distAccSubAlgorithm = atoi(args[3].c_str());
     }
+    else if (arg == "split_packs")
+    {
+        CC("split_packs", 1)
+        packSplitFactor = atof(args[1].c_str());
+    }
+    else if (arg == "merge_tree")
+    {
+        CC("merge_tree", 1)
+        mergeTreeLevels = atoi(args[1].c_str());
+    }
+    else if (arg == "local_input")
+    {
+        CC("local_input", 1)
+        inputType = 5;
+        localInputFilename = args[1];
+    }
+    else if (arg == "write_local_input")
+    {
+        CC("write_local_input", 1)
+        writeLocalInputFilename = args[1];
+    }
+    else if (arg == "dist_join")
+    {
+        CC("dist_join", 1)
+        distributedJoin = atoi(args[1].c_str());
+    }
+    else if (arg == "shm_workers")
+    {
+        CC("shm_workers", 1)
+        shmWorkersCount = atoi(args[1].c_str());
+    }
+    else if (arg == "st_frontier")
+    {
+        CC("st_frontier", 1)
+        singleSearchFrontier = atoi(args[1].c_str());
+    }
+    else if (arg == "hom")
+    {
+        CC("hom", 1)
+        homologyEngine = atoi(args[1].c_str());
+        if (homologyEngine < 0 || homologyEngine > HZ2_Parallel + 1)
+        {
+            throw std::string("Tests: unknown homology engine");
+        }
+    }
+    else if (arg == "stream")
+    {
+        CC("stream", 1)
+        streamOutput = atoi(args[1].c_str());
+    }
+    else if (arg == "stream_file")
+    {
+        CC("stream_file", 1)
+        streamFilename = args[1];
+    }
     else if (arg == "test")
     {
         CC("test", 1)
         accTestNumber = atoi(args[1].c_str());
     }
+    else if (arg == "stress")
+    {
+        CC("stress", 2)
+        stressRepeats = atoi(args[1].c_str());
+        stressPacksCount = atoi(args[2].c_str());
+    }
+    else if (arg == "partitions")
+    {
+        CC("partitions", 1)
+        partitionPacksCount = atoi(args[1].c_str());
+    }
+    else if (arg == "bench_output")
+    {
+        CC("bench_output", 1)
+        outputRepeats = atoi(args[1].c_str());
+    }
     else if (arg == "sv")
     {
         CC("sv", 1)
@@ -185,6 +330,23 @@ void Tests::ProcessArguments(int argc, char **argv)
     {
         ProcessArgument(args);
     }
+    // checked here, so computations are not started in vain
+    if (streamOutput && streamFilename == "" && homologyEngine == 0)
+    {
+        throw std::string("Tests: streaming output needs Z2 homology engine");
+    }
+    if (inputType == 5)
+    {
+#ifndef USE_MPI
+        throw std::string("Tests: local input needs MPI build");
+#endif
+        // packs are fixed parts of the file and master has no simplices
+        // to split or merge them
+        if (packSplitFactor > 0 || mergeTreeLevels > 0 || distributedJoin)
+        {
+            throw std::string("Tests: local input can't be used with --split_packs, --merge_tree or --dist_join");
+        }
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -198,32 +360,94 @@ bool Tests::IsAccSubReduction(ReductionType rt)
 
 void Tests::Test(SimplexList &simplexList, ReductionType reductionType)
 {
+    int dim = Simplex::GetSimplexListDimension(simplexList);
+    if (dim <= 4)
+    {
+        Test<IncidenceGraph>(simplexList, reductionType);
+    }
+    else if (dim == 5)
+    {
+        Test<IncidenceGraph5D>(simplexList, reductionType);
+    }
+#ifdef __SIZEOF_INT128__
+    else if (dim == 6)
+    {
+        Test<IncidenceGraph6D>(simplexList, reductionType);
+    }
+#endif
+    else
+    {
+        throw std::string("Tests: unsupported complex dimension");
+    }
+}
+
+template <typename IG>
+void Tests::Test(SimplexList &simplexList, ReductionType reductionType)
+{
+    typedef typename IG::AccTest AccTest;
+    typedef typename IG::AccSubAlgorithm AccSubAlgorithm;
+    typedef OutputGraphT<IG> OutputGraph;
+    typedef typename PartitionGraphSelector<IG>::PartitionGraph PartitionGraph;
+
+    // with local input master gets only simplices of reduced graph
+    bool localInput = (inputType == 5);
+    int dim = localInput ? localInputDim : Simplex::GetSimplexListDimension(simplexList);
+
+#ifdef USE_MPI
+    // slaves are always run with default incidence graph
+    if (reductionType == RT_AccSubDist && dim > 4)
+    {
+        throw std::string("Tests: MPI computations support only dim <= 4");
+    }
+#endif
+
     float total = 0;
 
     Timer::Update();
     Timer::Time timeStart = Timer::Now();
 
-    AccTest *accTest = IsAccSubReduction(reductionType) ? AccTest::Create(accTestNumber, Simplex::GetSimplexListDimension(simplexList)) : 0;
+    AccTest *accTest = IsAccSubReduction(reductionType) ? AccTest::Create(accTestNumber, dim) : 0;
     if (accTest)
     {
         std::cout<<"acyclic test number: "<<accTest->GetID()<<std::endl;
     }
-    IncidenceGraph *ig = 0;
+    IG::singleSearchFrontier = (singleSearchFrontier != 0);
+    IG *ig = 0;
     if (reductionType == RT_AccSub)
     {
-        ig = IncidenceGraphHelpers<IncidenceGraph>::CreateAndCalculateAccSub(simplexList, accTest);
+        ig = IncidenceGraphHelpers<IG>::CreateAndCalculateAccSub(simplexList, accTest);
     }
     else if (reductionType == RT_AccSubIG)
     {
-        ig = IncidenceGraphHelpers<IncidenceGraph>::CreateAndCalculateAccSubIG(simplexList, accTest);
+        ig = IncidenceGraphHelpers<IG>::CreateAndCalculateAccSubIG(simplexList, accTest);
     }
     else if (reductionType == RT_AccSubST)
     {
-        ig = IncidenceGraphHelpers<IncidenceGraph>::CreateAndCalculateAccSubST(simplexList, accTest);
+        ig = IncidenceGraphHelpers<IG>::CreateAndCalculateAccSubST(simplexList, accTest);
     }
     else if (reductionType == RT_AccSubDist)
     {
-        ig = IncidenceGraphHelpers<IncidenceGraph>::CreateAndCalculateAccSubDist<PartitionGraph>(simplexList, packsCount, (AccSubAlgorithm)distAccSubAlgorithm, accTest);
+        PartitionGraph::packSplitFactor = packSplitFactor;
+        PartitionGraph::mergeTreeLevels = mergeTreeLevels;
+#ifdef USE_SHM
+        ComputationsParallelSHM<PartitionGraph>::SetWorkersCount(shmWorkersCount);
+#endif
+#ifdef USE_MPI
+        if (localInput)
+        {
+            ig = IncidenceGraphHelpers<IG>::template CreateAndCalculateAccSubDistLocalInput<PartitionGraph>(localInputFilename, simplexList, packsCount, (AccSubAlgorithm)distAccSubAlgorithm, accTest);
+        }
+        else if (distributedJoin)
+        {
+            ig = IncidenceGraphHelpers<IG>::template CreateAndCalculateAccSubDistributed<PartitionGraph>(simplexList, packsCount, (AccSubAlgorithm)distAccSubAlgorithm, accTest);
+        }
+        else
+        {
+            ig = IncidenceGraphHelpers<IG>::template CreateAndCalculateAccSubDist<PartitionGraph>(simplexList, packsCount, (AccSubAlgorithm)distAccSubAlgorithm, accTest);
+        }
+#else
+        ig = IncidenceGraphHelpers<IG>::template CreateAndCalculateAccSubDist<PartitionGraph>(simplexList, packsCount, (AccSubAlgorithm)distAccSubAlgorithm, accTest);
+#endif
     }
     else // (reductionType == RT_Coreduction || reductionType == RT_None)
     {
@@ -231,6 +455,10 @@ void Tests::Test(SimplexList &simplexList, ReductionType reductionType)
     }
     if (accTest)
     {
+        if (accTest->GetStats() != 0)
+        {
+            accTest->GetStats()->Print();
+        }
         delete accTest;
     }
     total = Timer::TimeFrom(timeStart, "total graph processing");
@@ -243,18 +471,57 @@ void Tests::Test(SimplexList &simplexList, ReductionType reductionType)
 
     Timer::Update();
 
-    if (ig != 0)
+    if (ig != 0 && streamOutput)
+    {
+        timeStart = Timer::Now();
+        if (streamFilename != "")
+        {
+            typename OutputGraph::FileSink sink(streamFilename.c_str());
+            OutputGraph::Stream(ig, sink);
+            Timer::Update("streaming output");
+            MemoryInfo::Print();
+        }
+        else
+        {
+            HomologyZ2T<OutputGraph> homology;
+            OutputGraph::Stream(ig, homology);
+            Timer::Update("streaming output");
+            MemoryInfo::Print();
+            std::vector<int> betti;
+            homology.ComputeBettiNumbers(betti, (HomologyZ2Mode)(homologyEngine - 1));
+            Timer::Update("computing homology");
+            RedHomHelpers::PrintBettiNumbers(betti);
+        }
+        total += Timer::TimeFrom(timeStart);
+    }
+    else if (ig != 0)
     {
         OutputGraph *og = new OutputGraph(ig);
         total += Timer::Update("creating output");
         MemoryInfo::Print();
 
         timeStart = Timer::Now();
-        RedHomHelpers::ComputeBettiNumbers(og, reductionType == RT_Coreduction, reductionType != RT_None);
+        if (homologyEngine > 0)
+        {
+            ComputeBettiNumbersZ2(og);
+        }
+        else
+        {
+            RedHomHelpers::ComputeBettiNumbers(og, reductionType == RT_Coreduction, reductionType != RT_None);
+        }
         total += Timer::TimeFrom(timeStart);
 
         delete og;
     }
+    else if (homologyEngine > 0 && reductionType == RT_None)
+    {
+        timeStart = Timer::Now();
+        OutputGraph *og = new OutputGraph(simplexList);
+        Timer::Update("creating output");
+        ComputeBettiNumbersZ2(og);
+        delete og;
+        total += Timer::TimeFrom(timeStart);
+    }
     else
     {
         timeStart = Timer::Now();
@@ -268,11 +535,29 @@ void Tests::Test(SimplexList &simplexList, ReductionType reductionType)
     delete ig;
 }
 
+template <typename OutputGraph>
+void Tests::ComputeBettiNumbersZ2(OutputGraph *og)
+{
+    HomologyZ2T<OutputGraph> homology(og);
+    Timer::Update("creating boundary matrices");
+    MemoryInfo::Print();
+    std::vector<int> betti;
+    homology.ComputeBettiNumbers(betti, (HomologyZ2Mode)(homologyEngine - 1));
+    Timer::Update("computing homology");
+    RedHomHelpers::PrintBettiNumbers(betti);
+}
+
 void Tests::TestAndCompare(SimplexList &simplexList)
 {
     std::cout<<"simplices count: "<<simplexList.size()<<std::endl;
     std::cout<<"dim: "<<Simplex::GetSimplexListDimension(simplexList)<<std::endl;
 
+    if (writeLocalInputFilename != "")
+    {
+        WriteLocalInput(simplexList);
+        return;
+    }
+
     if (useAlgebraic)
     {
         std::cout<<std::endl<<"algebraic:"<<std::endl;
@@ -311,6 +596,177 @@ void Tests::TestAndCompare(SimplexList &simplexList)
         std::cout<<std::endl<<"AccSubDist:"<<std::endl;
         Test(simplexList, RT_AccSubDist);
     }
+
+    if (stressRepeats > 0)
+    {
+        std::cout<<std::endl<<"stress test:"<<std::endl;
+        StressTest(simplexList);
+    }
+
+    if (partitionPacksCount > 0)
+    {
+        std::cout<<std::endl<<"partitions:"<<std::endl;
+        ComparePartitions(simplexList);
+    }
+
+    if (outputRepeats > 0)
+    {
+        std::cout<<std::endl<<"output benchmark:"<<std::endl;
+        BenchmarkOutput(simplexList);
+    }
+}
+
+// all packs are computed with the same acyclicity test, so in parallel
+// builds (OpenMP) it is shared by all threads
+void Tests::StressTest(SimplexList &simplexList)
+{
+    typedef IncidenceGraph::AccTest AccTest;
+    typedef IncidenceGraph::AccSubAlgorithm AccSubAlgorithm;
+    typedef PartitionGraphT<IncidenceGraph, PrepareDataBFS, ComputationsLocal> PartitionGraphLocal;
+
+    int dim = Simplex::GetSimplexListDimension(simplexList);
+    if (dim > 4)
+    {
+        std::cout<<"stress test supports only dim <= 4"<<std::endl;
+        return;
+    }
+    AccTest *accTest = AccTest::Create(accTestNumber, dim);
+    std::cout<<"acyclic test number: "<<accTest->GetID()<<std::endl;
+    std::cout<<"packs count: "<<stressPacksCount<<std::endl;
+
+    Timer::Update();
+    IncidenceGraph *ig = IncidenceGraphHelpers<IncidenceGraph>::CreateAndCalculateAccSubDist<PartitionGraphLocal>(simplexList, stressPacksCount, (AccSubAlgorithm)distAccSubAlgorithm, accTest);
+    Timer::Update("sequential computations");
+    SimplexList remaining;
+    std::vector<int> betti;
+    GetReducedGraph(ig, remaining, betti);
+    delete ig;
+
+    int mismatches = 0;
+    float total = 0;
+    SimplexList repeatRemaining;
+    std::vector<int> repeatBetti;
+    for (int i = 0; i < stressRepeats; i++)
+    {
+        Timer::Update();
+        ig = IncidenceGraphHelpers<IncidenceGraph>::CreateAndCalculateAccSubDist<PartitionGraph>(simplexList, stressPacksCount, (AccSubAlgorithm)distAccSubAlgorithm, accTest);
+        total += Timer::Update();
+        GetReducedGraph(ig, repeatRemaining, repeatBetti);
+        if (repeatRemaining != remaining || repeatBetti != betti)
+        {
+            mismatches++;
+        }
+        delete ig;
+    }
+    std::cout<<"distributed computations : "<<total<<"s"<<std::endl;
+    std::cout<<"average: "<<(total / stressRepeats)<<"s"<<std::endl;
+    std::cout<<"remaining simplices: "<<remaining.size()<<" mismatches: "<<mismatches<<std::endl;
+    RedHomHelpers::PrintBettiNumbers(betti);
+    if (accTest->GetStats() != 0)
+    {
+        accTest->GetStats()->Print();
+    }
+    delete accTest;
+}
+
+// distributed computations leave in the graph only simplices not included
+// in the acyclic subset. they are compared sorted, together with Betti
+// numbers (Z2) of output graph
+void Tests::GetReducedGraph(IncidenceGraph *ig, SimplexList &simplices, std::vector<int> &betti)
+{
+    typedef OutputGraphT<IncidenceGraph> OutputGraph;
+
+    simplices.clear();
+    for (IncidenceGraph::Nodes::iterator i = ig->nodes.begin(); i != ig->nodes.end(); i++)
+    {
+        simplices.push_back(*(*i)->simplex);
+    }
+    std::sort(simplices.begin(), simplices.end());
+    OutputGraph *og = new OutputGraph(ig);
+    HomologyZ2T<OutputGraph> homology(og);
+    homology.ComputeBettiNumbers(betti, HZ2_Clearing);
+    delete og;
+}
+
+// acyclic subset is computed once, output graph is created repeatedly
+// from the same incidence graph (output flags are cleared every time)
+void Tests::BenchmarkOutput(SimplexList &simplexList)
+{
+    typedef IncidenceGraph::AccTest AccTest;
+    typedef OutputGraphT<IncidenceGraph> OutputGraph;
+
+    int dim = Simplex::GetSimplexListDimension(simplexList);
+    if (dim > 4)
+    {
+        std::cout<<"output benchmark supports only dim <= 4"<<std::endl;
+        return;
+    }
+    AccTest *accTest = AccTest::Create(accTestNumber, dim);
+    IncidenceGraph *ig = IncidenceGraphHelpers<IncidenceGraph>::CreateAndCalculateAccSubIG(simplexList, accTest);
+    delete accTest;
+    std::cout<<"acyclic subset size: "<<ig->GetAccSubSize()<<std::endl;
+
+    int outputSize = 0;
+    Timer::Time timeStart = Timer::Now();
+    for (int i = 0; i < outputRepeats; i++)
+    {
+        for (IncidenceGraph::Nodes::iterator n = ig->nodes.begin(); n != ig->nodes.end(); n++)
+        {
+            (*n)->IsAddedToOutput(false);
+            (*n)->IsAddedToQueue(false);
+        }
+        OutputGraph *og = new OutputGraph(ig);
+        outputSize = og->nodes.size();
+        delete og;
+    }
+    float total = Timer::TimeFrom(timeStart, "creating output");
+    std::cout<<"average: "<<(total / outputRepeats)<<"s"<<std::endl;
+    std::cout<<"output size: "<<outputSize<<std::endl;
+    delete ig;
+
+    timeStart = Timer::Now();
+    for (int i = 0; i < outputRepeats; i++)
+    {
+        OutputGraph *og = new OutputGraph(simplexList);
+        outputSize = og->nodes.size();
+        delete og;
+    }
+    total = Timer::TimeFrom(timeStart, "creating output from simplex list");
+    std::cout<<"average: "<<(total / outputRepeats)<<"s"<<std::endl;
+    std::cout<<"output size: "<<outputSize<<std::endl;
+}
+
+void Tests::ComparePartitions(SimplexList &simplexList)
+{
+    if (Simplex::GetSimplexListDimension(simplexList) > 4)
+    {
+        std::cout<<"partitions comparison supports only dim <= 4"<<std::endl;
+        return;
+    }
+    std::cout<<"packs count: "<<partitionPacksCount<<std::endl;
+    ComparePartitions<PartitionGraphT<IncidenceGraph, PrepareDataBFS, ComputationsLocal> >(simplexList, "BFS");
+    ComparePartitions<PartitionGraphT<IncidenceGraph, PrepareDataMultilevel, ComputationsLocal> >(simplexList, "multilevel");
+}
+
+template <typename PartitionGraph>
+void Tests::ComparePartitions(SimplexList &simplexList, const char *name)
+{
+    typedef IncidenceGraph::AccTest AccTest;
+    typedef IncidenceGraph::AccSubAlgorithm AccSubAlgorithm;
+
+    // partitioning reorders simplices, so every policy gets the same copy
+    SimplexList simplices(simplexList);
+    AccTest *accTest = AccTest::Create(accTestNumber, Simplex::GetSimplexListDimension(simplices));
+    std::cout<<std::endl<<name<<":"<<std::endl;
+    Timer::Time timeStart = Timer::Now();
+    PartitionGraph *pg = new PartitionGraph(simplices, partitionPacksCount, (AccSubAlgorithm)distAccSubAlgorithm, accTest);
+    Timer::TimeFrom(timeStart, "partitioning and computations");
+    std::cout<<"border vertices: "<<pg->GetBorderVertsCount()<<std::endl;
+    std::cout<<"packs connections: "<<pg->edges.size()<<std::endl;
+    std::cout<<"combined graph size: "<<pg->GetIncidenceGraph()->nodes.size()<<std::endl;
+    delete pg->GetIncidenceGraph();
+    delete pg;
+    delete accTest;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -367,6 +823,117 @@ void Tests::TestRandomRipsComplex()
     TestAndCompare(simplexList);
 }
 
+void Tests::TestBand()
+{
+    std::cout<<"generating band with:"<<std::endl;
+    std::cout<<"count = "<<bandSimplicesCount<<std::endl;
+    std::cout<<"dim = "<<bandDim<<std::endl;
+    SimplexList simplexList;
+    Timer::Init();
+    SimplexUtils<Simplex>::GenerateBand(simplexList, bandSimplicesCount, bandDim);
+    std::cout<<"input size: "<<simplexList.size()<<std::endl;
+    Timer::Update("data generated");
+    MemoryInfo::Print();
+    TestAndCompare(simplexList);
+}
+
+// master reads only the beginning of the file to find dimension,
+// the rest is read once while partitioning
+void Tests::TestLocalInput()
+{
+    std::cout<<"testing "<<localInputFilename<<std::endl;
+    Timer::Init();
+    localInputDim = SimplexListBinary<Simplex>::GetDimension(localInputFilename.c_str());
+    std::cout<<"dim: "<<localInputDim<<std::endl;
+    // filled with simplices of reduced graph
+    SimplexList simplexList;
+    std::cout<<std::endl<<"AccSubDist:"<<std::endl;
+    Test<IncidenceGraph>(simplexList, RT_AccSubDist);
+}
+
+// simplices are ordered like before partitioning (BFS doesn't depend
+// on pack size), so packs of local input are their consecutive parts
+void Tests::WriteLocalInput(SimplexList &simplexList)
+{
+    PrepareDataBFS<PartitionGraph>::Prepare(simplexList, 0);
+    Timer::Update("preparing data");
+    SimplexListBinary<Simplex>::Write(simplexList, writeLocalInputFilename.c_str());
+    Timer::Update("writing local input");
+    std::cout<<"local input written to "<<writeLocalInputFilename<<std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void Tests::BenchmarkIntersectionFlags()
+{
+    typedef IncidenceGraphT<IncidenceGraphTraitsDim<4>, IntersectionInfoFlags, AccInfoFlags> IncidenceGraphBitSet4;
+    typedef IncidenceGraphT<IncidenceGraphTraitsDim<5>, IntersectionInfoFlags, AccInfoFlags> IncidenceGraphBitSet5;
+    typedef IncidenceGraphT<IncidenceGraphTraitsDim<6>, IntersectionInfoFlags, AccInfoFlags> IncidenceGraphBitSet6;
+
+    std::cout<<"updating acyclic intersection flags "<<benchmarkIterations<<" times"<<std::endl;
+    Timer::Init();
+    BenchmarkIntersectionFlags<IncidenceGraph>(4, "unsigned int");
+    BenchmarkIntersectionFlags<IncidenceGraphBitSet4>(4, "IntersectionFlagsBitSet<4>");
+    BenchmarkIntersectionFlags<IncidenceGraph5D>(5, "uint64_t");
+    BenchmarkIntersectionFlags<IncidenceGraphBitSet5>(5, "IntersectionFlagsBitSet<5>");
+#ifdef __SIZEOF_INT128__
+    BenchmarkIntersectionFlags<IncidenceGraph6D>(6, "unsigned __int128");
+#endif
+    BenchmarkIntersectionFlags<IncidenceGraphBitSet6>(6, "IntersectionFlagsBitSet<6>");
+}
+
+template <typename IG>
+void Tests::BenchmarkIntersectionFlags(int dim, const char *name)
+{
+    typedef typename IG::IntersectionFlags IntersectionFlags;
+    typedef typename IG::AccInfo AccInfo;
+
+    ConfigurationsFlags<Simplex, IntersectionFlags> configurationsFlags(dim, false, true);
+    ConfigurationsFlags<Simplex, IntersectionFlags> subconfigurationsFlags(dim, true, true);
+    Simplex simplex;
+    for (int i = 0; i <= dim; i++)
+    {
+        simplex.push_back(i);
+    }
+    SimplexList faces;
+    simplex.GenerateProperFaces(faces);
+    std::vector<IntersectionFlags> flags;
+    std::vector<IntersectionFlags> flagsMF;
+    for (typename SimplexList::iterator i = faces.begin(); i != faces.end(); i++)
+    {
+        flags.push_back(subconfigurationsFlags[*i]);
+        flagsMF.push_back(configurationsFlags[*i]);
+    }
+    // the same sequence of faces for every flags type of given dim
+    srand(dim);
+    std::vector<int> sequence;
+    for (int i = 0; i < benchmarkIterations; i++)
+    {
+        sequence.push_back(rand() % faces.size());
+    }
+
+    Timer::Update();
+    Timer::Time timeStart = Timer::Now();
+    IntersectionFlags intersectionFlags = 0;
+    IntersectionFlags intersectionFlagsMF = 0;
+    int checksum = 0;
+    for (int i = 0; i < benchmarkIterations; i++)
+    {
+        // every few updates we start with intersection of another node
+        if (i % 8 == 0)
+        {
+            checksum += IntersectionFlagsHelpers<IntersectionFlags>::PopCount(intersectionFlagsMF);
+            intersectionFlags = 0;
+            intersectionFlagsMF = 0;
+        }
+        int f = sequence[i];
+        AccInfo::UpdateAccIntersectionFlags(intersectionFlags, intersectionFlagsMF, flags[f], flagsMF[f]);
+    }
+    std::string msg = std::string(name) + " (dim " + (char)('0' + dim) + ")";
+    Timer::TimeFrom(timeStart, msg.c_str());
+    std::cout<<"checksum: "<<checksum<<std::endl;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 
 void Tests::TestFromCommandLine(int argc, char **argv)
@@ -386,6 +953,15 @@ void Tests::TestFromCommandLine(int argc, char **argv)
         case 2:
             TestRandomRipsComplex();
             break;
+        case 3:
+            BenchmarkIntersectionFlags();
+            break;
+        case 4:
+            TestBand();
+            break;
+        case 5:
+            TestLocalInput();
+            break;
         default:
             break;
     }
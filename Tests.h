@@ -24,6 +24,7 @@
 #include "ComputationsLocalMPITest.hpp"
 #include "ComputationsParallelMPI.hpp"
 #include "ComputationsParallelOMP.hpp"
+#include "ComputationsParallelSHM.hpp"
 
 enum ReductionType
 {
@@ -40,20 +41,31 @@ class Tests
     typedef IncidenceGraphT<IncidenceGraphDefaultTraits, IntersectionInfoFlags, AccInfoFlags> IncidenceGraph;
     typedef IncidenceGraph::Simplex Simplex;
     typedef IncidenceGraph::SimplexList SimplexList;
-    typedef IncidenceGraph::AccTest AccTest;
-    typedef IncidenceGraph::AccSubAlgorithm AccSubAlgorithm;
 
-    typedef OutputGraphT<IncidenceGraph> OutputGraph;
+    // default flags (unsigned int) are enough for dim <= 4
+    typedef IncidenceGraphT<IncidenceGraphTraitsFlags<uint64_t>, IntersectionInfoFlags, AccInfoFlags> IncidenceGraph5D;
+#ifdef __SIZEOF_INT128__
+    typedef IncidenceGraphT<IncidenceGraphTraitsFlags<unsigned __int128>, IntersectionInfoFlags, AccInfoFlags> IncidenceGraph6D;
+#endif
 
+    template <typename IG>
+    class PartitionGraphSelector
+    {
+    public:
 #ifdef USE_MPI
-    typedef PartitionGraphT<IncidenceGraph, PrepareDataBFS, ComputationsParallelMPI> PartitionGraph;
+        typedef PartitionGraphT<IG, PrepareDataBFS, ComputationsParallelMPI> PartitionGraph;
+#elif defined(USE_SHM)
+        typedef PartitionGraphT<IG, PrepareDataBFS, ComputationsParallelSHM> PartitionGraph;
 #else
 #ifdef USE_OMP
-    typedef PartitionGraphT<IncidenceGraph, PrepareDataBFS, ComputationsParallelOMP> PartitionGraph;
+        typedef PartitionGraphT<IG, PrepareDataBFS, ComputationsParallelOMP> PartitionGraph;
 #else
-    typedef PartitionGraphT<IncidenceGraph, PrepareDataBFS, ComputationsLocalMPITest> PartitionGraph;
+        typedef PartitionGraphT<IG, PrepareDataBFS, ComputationsLocalMPITest> PartitionGraph;
 #endif
 #endif
+    };
+
+    typedef PartitionGraphSelector<IncidenceGraph>::PartitionGraph PartitionGraph;
 
 public:
 
@@ -66,6 +78,9 @@ private:
     // 0 - single file
     // 1 - list
     // 2 - random rips complex
+    // 3 - intersection flags benchmark
+    // 4 - band around a ring
+    // 5 - binary file read by MPI slaves (local input)
     static int              inputType;
     static int              accTestNumber;
     static std::string      inputFilename;
@@ -84,6 +99,24 @@ private:
     static int              randomPointsDim;
     static float            ripsComplexEpsilon;
     static int              ripsComplexDim;
+    static int              benchmarkIterations;
+    static int              bandSimplicesCount;
+    static int              bandDim;
+    static int              stressRepeats;
+    static int              stressPacksCount;
+    static int              partitionPacksCount;
+    static float            packSplitFactor;
+    static int              mergeTreeLevels;
+    static std::string      localInputFilename;
+    static int              localInputDim;
+    static std::string      writeLocalInputFilename;
+    static int              distributedJoin;
+    static int              shmWorkersCount;
+    static int              singleSearchFrontier;
+    static int              outputRepeats;
+    static int              homologyEngine;
+    static int              streamOutput;
+    static std::string      streamFilename;
 
     static void PrintHelp();
     static void ProcessArgument(std::vector<std::string> &args);
@@ -92,11 +125,27 @@ private:
     static bool IsAccSubReduction(ReductionType);
 
     static void Test(SimplexList &, ReductionType);
+    static void StressTest(SimplexList &);
+    static void GetReducedGraph(IncidenceGraph *, SimplexList &, std::vector<int> &);
+    static void ComparePartitions(SimplexList &);
+    static void BenchmarkOutput(SimplexList &);
+    template <typename PartitionGraph>
+    static void ComparePartitions(SimplexList &, const char *name);
+    template <typename IG>
+    static void Test(SimplexList &, ReductionType);
+    template <typename OutputGraph>
+    static void ComputeBettiNumbersZ2(OutputGraph *);
     static void TestAndCompare(SimplexList &);
 
     static void TestSingleFile();
     static void TestFromList();
     static void TestRandomRipsComplex();
+    static void TestBand();
+    static void TestLocalInput();
+    static void WriteLocalInput(SimplexList &);
+    static void BenchmarkIntersectionFlags();
+    template <typename IG>
+    static void BenchmarkIntersectionFlags(int dim, const char *name);
 
     static void MPIMaster(int argc, char **argv);
     static void MPISlave(int processRank);
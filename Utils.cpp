@@ -20,6 +20,10 @@
 #include <mpi.h>
 #endif
 
+#ifdef USE_OMP
+#include <omp.h>
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 // Timer
 
@@ -31,6 +35,9 @@ void Timer::Init()
 #ifdef USE_MPI
     now = MPI_Wtime();
     timeStart = MPI_Wtime();
+#elif defined(USE_OMP)
+    now = omp_get_wtime();
+    timeStart = omp_get_wtime();
 #else
     now = clock();
     timeStart = clock();
@@ -42,6 +49,9 @@ float Timer::Update(const char *msg)
 #ifdef USE_MPI
     double t = MPI_Wtime();
     float s = float(t - now);
+#elif defined(USE_OMP)
+    double t = omp_get_wtime();
+    float s = float(t - now);
 #else
     clock_t t = clock();
     float s = float(t - now) / CLOCKS_PER_SEC;
@@ -56,6 +66,9 @@ float Timer::Update()
 #ifdef USE_MPI
     double t = MPI_Wtime();
     float s = float(t - now);
+#elif defined(USE_OMP)
+    double t = omp_get_wtime();
+    float s = float(t - now);
 #else
     clock_t t = clock();
     float s = float(t - now) / CLOCKS_PER_SEC;
@@ -73,6 +86,8 @@ float Timer::TimeFrom(Timer::Time t, const char *msg)
 {
 #ifdef USE_MPI
     float s = float(MPI_Wtime() - t);
+#elif defined(USE_OMP)
+    float s = float(omp_get_wtime() - t);
 #else
     float s = float(clock() - t) / CLOCKS_PER_SEC;
 #endif
@@ -84,6 +99,8 @@ float Timer::TimeFrom(Timer::Time t)
 {
 #ifdef USE_MPI
     float s = float(MPI_Wtime() - t);
+#elif defined(USE_OMP)
+    float s = float(omp_get_wtime() - t);
 #else
     float s = float(clock() - t) / CLOCKS_PER_SEC;
 #endif
@@ -94,6 +111,8 @@ void Timer::TimeStamp(const char* msg)
 {
 #ifdef USE_MPI
     std::cout<<msg<<" : "<<float(MPI_Wtime() - timeStart)<<std::endl;
+#elif defined(USE_OMP)
+    std::cout<<msg<<" : "<<float(omp_get_wtime() - timeStart)<<std::endl;
 #else
     std::cout<<msg<<" : "<<(float(clock() - timeStart) / CLOCKS_PER_SEC)<<"s"<<std::endl;
 #endif
@@ -18,11 +18,16 @@
 #include <ctime>
 #include <algorithm>
 #include <map>
+#include <vector>
 
 #ifdef USE_MPI
 #include <mpi.h>
 #endif
 
+#ifdef USE_OMP
+#include <omp.h>
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 // Debug
 
@@ -155,7 +160,6 @@ public:
     template <typename OutputGraph>
     static void PrintOutputGraph(std::ostream &str, OutputGraph &graph)
     {
-        std::sort(graph.nodes.begin(), graph.nodes.end(), OutputGraph::Node::Sorter);
         for (typename OutputGraph::Nodes::iterator i = graph.nodes.begin(); i != graph.nodes.end(); i++)
         {
             str<<"node "<<(*i)->index<<" : ";
@@ -184,6 +188,138 @@ public:
     }
 };
 
+////////////////////////////////////////////////////////////////////////////////
+// OpenMP threads (one thread without USE_OMP)
+
+class Threads
+{
+
+public:
+
+    static int GetThreadsCount()
+    {
+#ifdef USE_OMP
+        return omp_get_max_threads();
+#else
+        return 1;
+#endif
+    }
+
+    static int GetThreadNumber()
+    {
+#ifdef USE_OMP
+        return omp_get_thread_num();
+#else
+        return 0;
+#endif
+    }
+
+    // objects with data kept per thread get unique numbers, which are
+    // never reused
+    static int NextObjectID()
+    {
+        static int nextID = 0;
+        int id;
+#ifdef USE_OMP
+        #pragma omp critical (ThreadsNextObjectID)
+#endif
+        id = nextID++;
+        return id;
+    }
+
+    // data of calling thread for all objects, indexed by object ID.
+    // tables are kept until the end of program, as finished threads
+    // can't free them
+    static std::vector<void *> &GetThreadTable()
+    {
+        static std::vector<void *> *table = 0;
+#ifdef USE_OMP
+        #pragma omp threadprivate(table)
+#endif
+        if (table == 0)
+        {
+            static std::vector<std::vector<void *> *> *tables = new std::vector<std::vector<void *> *>();
+            table = new std::vector<void *>();
+#ifdef USE_OMP
+            #pragma omp critical (ThreadsTables)
+#endif
+            tables->push_back(table);
+        }
+        return *table;
+    }
+
+};
+
+// copies of data of an object shared by OpenMP threads, one per thread.
+// thread finds its copy in its own table, so there are no locks on
+// access, number of threads can change and parallel regions can be nested.
+// copies are created from prototype when thread uses them first time
+template <typename T>
+class ThreadsData
+{
+    int id;
+    T prototype;
+    std::vector<T *> copies;
+
+    ThreadsData(const ThreadsData &);
+    ThreadsData &operator=(const ThreadsData &);
+
+public:
+
+    typedef typename std::vector<T *>::const_iterator const_iterator;
+
+    ThreadsData(const T &prototype = T()) : id(Threads::NextObjectID()), prototype(prototype) { }
+
+    ~ThreadsData()
+    {
+        Clear();
+    }
+
+    // existing copies are deleted, so it can't be called inside parallel
+    // region. new ID is taken, so tables of threads don't point to them
+    void SetPrototype(const T &prototype)
+    {
+        Clear();
+        this->prototype = prototype;
+        id = Threads::NextObjectID();
+    }
+
+    T &Get()
+    {
+        std::vector<void *> &table = Threads::GetThreadTable();
+        if (id >= (int)table.size())
+        {
+            table.resize(id + 1, (void *)0);
+        }
+        if (table[id] == 0)
+        {
+            T *copy = new T(prototype);
+#ifdef USE_OMP
+            #pragma omp critical (ThreadsData)
+#endif
+            copies.push_back(copy);
+            table[id] = copy;
+        }
+        return *static_cast<T *>(table[id]);
+    }
+
+    // copies of all threads, can't be used inside parallel region
+    const_iterator begin() const { return copies.begin(); }
+    const_iterator end() const { return copies.end(); }
+
+private:
+
+    void Clear()
+    {
+        for (typename std::vector<T *>::iterator i = copies.begin(); i != copies.end(); i++)
+        {
+            delete (*i);
+        }
+        copies.clear();
+    }
+
+};
+
 ////////////////////////////////////////////////////////////////////////////////
 
 class Timer
@@ -191,7 +327,7 @@ class Timer
 
 public:
 
-#ifdef USE_MPI
+#if defined(USE_MPI) || defined(USE_OMP)
     typedef double Time;
 #else
     typedef clock_t Time;
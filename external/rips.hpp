@@ -16,6 +16,9 @@
 #include <sstream>
 #include <fstream>
 #include <limits>
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
 #include "reduction.h"
 
 
@@ -797,4 +800,258 @@ std::vector<int> bettiNumbers( std::vector< std::vector< std::pair< double, doub
     return betti;
 }
 
+
+//Epsilon-graph of points with float coordinates (stored point after point) for big point clouds.
+//Points are sorted into a uniform grid of cells with side not smaller than epsilon (only first
+//three coordinates are used for cells), so neighbours are searched in adjacent cells only.
+//Coordinates are padded with zeros to a multiple of four and distances are computed with SSE.
+//Graph is built in two passes (counting and filling neighbours) which are parallel in OpenMP
+//builds. Adjacency is kept in a single array, neighbours of every point are sorted.
+class epsilonGraph
+{
+public:
+    epsilonGraph( const std::vector<float>& coords , int dim , float epsilon );
+
+    int size() const { return offsets.size() - 1; }
+
+    //maximal simplices of Rips complex restricted to dimension maxDim (vertices of simplices are
+    //sorted), the same as simplicialComplex::outputMaxSimplices gives
+    void outputMaxSimplices( int maxDim , std::vector< std::vector<int> >& simplices ) const;
+
+private:
+    std::vector<int> offsets;
+    std::vector<int> neighbours;
+
+    std::vector<int>::const_iterator neighboursBegin( int v ) const { return neighbours.begin() + offsets[v]; }
+    std::vector<int>::const_iterator neighboursEnd( int v ) const { return neighbours.begin() + offsets[v+1]; }
+    std::vector<int>::const_iterator higherNeighboursBegin( int v ) const { return std::upper_bound( neighboursBegin(v) , neighboursEnd(v) , v ); }
+
+    bool isAdjacent( int v , int w ) const { return std::binary_search( neighboursBegin(v) , neighboursEnd(v) , w ); }
+    bool isMaximal( const std::vector<int>& simplex ) const;
+    void expand( std::vector<int>& simplex , const std::vector<int>& candidates , int maxDim , std::vector< std::vector<int> >& simplices ) const;
+
+    static float squaredDistance( const float* a , const float* b , int paddedDim )
+    {
+#ifdef __SSE__
+        __m128 sum = _mm_setzero_ps();
+        for ( int k = 0 ; k < paddedDim ; k += 4 )
+        {
+            __m128 d = _mm_sub_ps( _mm_loadu_ps( a + k ) , _mm_loadu_ps( b + k ) );
+            sum = _mm_add_ps( sum , _mm_mul_ps( d , d ) );
+        }
+        float s[4];
+        _mm_storeu_ps( s , sum );
+        return s[0] + s[1] + s[2] + s[3];
+#else
+        float sum = 0;
+        for ( int k = 0 ; k < paddedDim ; ++k )
+        {
+            sum += (a[k] - b[k])*(a[k] - b[k]);
+        }
+        return sum;
+#endif
+    }
+};
+
+inline epsilonGraph::epsilonGraph( const std::vector<float>& coords , int dim , float epsilon )
+{
+    const int gridDim = std::min( dim , 3 );
+    const int paddedDim = (dim + 3) / 4 * 4;
+    const int maxCells = 1 << 20;
+    int n = (dim > 0) ? coords.size() / dim : 0;
+
+    //size of cells and number of cells in every grid dimension
+    std::vector<float> minCoords( gridDim , std::numeric_limits<float>::max() );
+    std::vector<float> maxCoords( gridDim , -std::numeric_limits<float>::max() );
+    for ( int i = 0 ; i != n ; ++i )
+    {
+        for ( int g = 0 ; g != gridDim ; ++g )
+        {
+            minCoords[g] = std::min( minCoords[g] , coords[i*dim + g] );
+            maxCoords[g] = std::max( maxCoords[g] , coords[i*dim + g] );
+        }
+    }
+    float cellSize = epsilon;
+    for ( int g = 0 ; g != gridDim ; ++g )
+    {
+        cellSize = std::max( cellSize , (maxCoords[g] - minCoords[g]) / maxCells );
+    }
+    if ( cellSize <= 0 ){cellSize = 1;}
+    std::vector<int> cellsCount( gridDim );
+    for ( int g = 0 ; g != gridDim ; ++g )
+    {
+        cellsCount[g] = (int)((maxCoords[g] - minCoords[g]) / cellSize) + 1;
+    }
+
+    //points sorted by keys of cells
+    std::vector<int> cells( n * gridDim );
+    std::vector< std::pair< long long , int > > order( n );
+    for ( int i = 0 ; i != n ; ++i )
+    {
+        long long key = 0;
+        for ( int g = 0 ; g != gridDim ; ++g )
+        {
+            int c = std::min( (int)((coords[i*dim + g] - minCoords[g]) / cellSize) , cellsCount[g] - 1 );
+            cells[i*gridDim + g] = c;
+            key = key * cellsCount[g] + c;
+        }
+        order[i] = std::make_pair( key , i );
+    }
+    std::sort( order.begin() , order.end() );
+    std::vector<long long> cellKeys;
+    std::vector<int> cellStarts;
+    std::vector<float> sorted( n * paddedDim , 0 );
+    for ( int s = 0 ; s != n ; ++s )
+    {
+        if ( s == 0 || order[s].first != order[s-1].first )
+        {
+            cellKeys.push_back( order[s].first );
+            cellStarts.push_back( s );
+        }
+        std::copy( coords.begin() + order[s].second * dim , coords.begin() + (order[s].second + 1) * dim , sorted.begin() + s * paddedDim );
+    }
+    cellStarts.push_back( n );
+
+    int adjacentCount = 1;
+    for ( int g = 0 ; g != gridDim ; ++g ){adjacentCount *= 3;}
+    const float squaredEpsilon = epsilon * epsilon;
+
+    //first pass counts neighbours, second one writes them
+    std::vector<int> counts( n + 1 , 0 );
+    std::vector<int> higher;
+    for ( int pass = 0 ; pass != 2 ; ++pass )
+    {
+#ifdef USE_OMP
+        #pragma omp parallel for schedule(dynamic, 256)
+#endif
+        for ( int s = 0 ; s < n ; ++s )
+        {
+            int i = order[s].second;
+            int count = 0;
+            for ( int a = 0 ; a != adjacentCount ; ++a )
+            {
+                long long key = 0;
+                bool inside = true;
+                for ( int g = 0 , rest = a ; g != gridDim ; ++g , rest /= 3 )
+                {
+                    int c = cells[i*gridDim + g] + rest % 3 - 1;
+                    if ( c < 0 || c >= cellsCount[g] ){inside = false;break;}
+                    key = key * cellsCount[g] + c;
+                }
+                if ( !inside ){continue;}
+                std::vector<long long>::const_iterator cell = std::lower_bound( cellKeys.begin() , cellKeys.end() , key );
+                if ( cell == cellKeys.end() || *cell != key ){continue;}
+                int k = cell - cellKeys.begin();
+                for ( int t = cellStarts[k] ; t != cellStarts[k+1] ; ++t )
+                {
+                    int j = order[t].second;
+                    if ( j <= i ){continue;}
+                    if ( squaredDistance( &sorted[s * paddedDim] , &sorted[t * paddedDim] , paddedDim ) <= squaredEpsilon )
+                    {
+                        if ( pass == 1 ){higher[counts[i] + count] = j;}
+                        ++count;
+                    }
+                }
+            }
+            if ( pass == 0 ){counts[i+1] = count;}
+            else {std::sort( higher.begin() + counts[i] , higher.begin() + counts[i] + count );}
+        }
+        if ( pass == 0 )
+        {
+            for ( int i = 0 ; i != n ; ++i ){counts[i+1] += counts[i];}
+            higher.resize( counts[n] );
+        }
+    }
+
+    //lower neighbours of every point go first, they are written in ascending order
+    std::vector<int> degrees( n , 0 );
+    for ( int i = 0 ; i != n ; ++i )
+    {
+        degrees[i] += counts[i+1] - counts[i];
+        for ( int k = counts[i] ; k != counts[i+1] ; ++k ){++degrees[ higher[k] ];}
+    }
+    this->offsets.assign( n + 1 , 0 );
+    for ( int i = 0 ; i != n ; ++i ){this->offsets[i+1] = this->offsets[i] + degrees[i];}
+    this->neighbours.resize( this->offsets[n] );
+    std::vector<int> positions( this->offsets.begin() , this->offsets.end() - 1 );
+    for ( int i = 0 ; i != n ; ++i )
+    {
+        for ( int k = counts[i] ; k != counts[i+1] ; ++k ){this->neighbours[ positions[ higher[k] ]++ ] = i;}
+    }
+    for ( int i = 0 ; i != n ; ++i )
+    {
+        std::copy( higher.begin() + counts[i] , higher.begin() + counts[i+1] , this->neighbours.begin() + positions[i] );
+    }
+}
+
+//simplex is maximal if no other vertex is adjacent to all its vertices. it is called only when
+//there is no such vertex greater than vertices of simplex
+inline bool epsilonGraph::isMaximal( const std::vector<int>& simplex ) const
+{
+    for ( std::vector<int>::const_iterator w = neighboursBegin( simplex[0] ) ; w != neighboursEnd( simplex[0] ) && *w < simplex.back() ; ++w )
+    {
+        bool common = true;
+        for ( size_t k = 1 ; k != simplex.size() && common ; ++k )
+        {
+            common = ( *w != simplex[k] && isAdjacent( simplex[k] , *w ) );
+        }
+        if ( common ){return false;}
+    }
+    return true;
+}
+
+//candidates are common neighbours of simplex greater than its vertices
+inline void epsilonGraph::expand( std::vector<int>& simplex , const std::vector<int>& candidates , int maxDim , std::vector< std::vector<int> >& simplices ) const
+{
+    if ( (int)simplex.size() == maxDim + 1 )
+    {
+        simplices.push_back( simplex );
+        return;
+    }
+    if ( candidates.empty() )
+    {
+        if ( this->isMaximal( simplex ) ){simplices.push_back( simplex );}
+        return;
+    }
+    std::vector<int> next;
+    for ( size_t i = 0 ; i != candidates.size() ; ++i )
+    {
+        next.clear();
+        std::set_intersection( candidates.begin() + i + 1 , candidates.end() , this->higherNeighboursBegin( candidates[i] ) , this->neighboursEnd( candidates[i] ) , std::back_inserter( next ) );
+        simplex.push_back( candidates[i] );
+        this->expand( simplex , next , maxDim , simplices );
+        simplex.pop_back();
+    }
+}
+
+inline void epsilonGraph::outputMaxSimplices( int maxDim , std::vector< std::vector<int> >& simplices ) const
+{
+    //simplicialComplex always creates edges
+    maxDim = std::max( maxDim , 1 );
+    //simplices are collected in blocks of vertices, so their order does not depend on threads
+    const int blockSize = 1024;
+    int n = this->size();
+    int blocksCount = (n + blockSize - 1) / blockSize;
+    std::vector< std::vector< std::vector<int> > > blocks( blocksCount );
+#ifdef USE_OMP
+    #pragma omp parallel for schedule(dynamic)
+#endif
+    for ( int b = 0 ; b < blocksCount ; ++b )
+    {
+        std::vector<int> simplex;
+        std::vector<int> candidates;
+        for ( int v = b * blockSize ; v != std::min( n , (b + 1) * blockSize ) ; ++v )
+        {
+            simplex.assign( 1 , v );
+            candidates.assign( this->higherNeighboursBegin( v ) , this->neighboursEnd( v ) );
+            this->expand( simplex , candidates , maxDim , blocks[b] );
+        }
+    }
+    for ( int b = 0 ; b != blocksCount ; ++b )
+    {
+        simplices.insert( simplices.end() , blocks[b].begin() , blocks[b].end() );
+        std::vector< std::vector<int> >().swap( blocks[b] );
+    }
+}
+
 }